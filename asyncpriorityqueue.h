@@ -0,0 +1,245 @@
+// asyncpriorityqueue.h
+//
+// A priorityqueue that C++20 coroutines can co_await on.
+//
+// async_dequeue() returns an awaitable that yields optional<T>.  If the
+// queue has an element the coroutine does not suspend at all.  Otherwise it is parked in a FIFO of
+// waiters and the next enqueue hands its value straight to the oldest
+// waiter, skipping the BST.  The waiter is then either resumed inline on
+// the producer's enqueue call or passed to a user-supplied executor
+// (e.g. an event loop's post function).
+//
+// Like priorityqueue this class does no locking: it is meant to be used
+// from a single thread, such as one event loop.  The waiter list is
+// intrusive (each waiter lives in its awaiting coroutine's frame), so
+// suspending never allocates.  A coroutine destroyed while suspended in
+// async_dequeue() takes its waiter off the list.
+//
+// close() wakes every waiter with nullopt, as does the destructor, so
+// consumers can shut down; once closed and drained, async_dequeue() yields
+// nullopt without suspending.
+#pragma once
+
+#include <coroutine>
+#include <functional>
+#include <optional>
+
+#include "priorityqueue.h"
+
+template<typename T>
+class asyncpriorityqueue {
+ private:
+    struct WAITER {
+        coroutine_handle<> handle;  // suspended consumer
+        T value;  // value handed over by enqueue
+        bool ready;  // true once value has been handed over
+        bool closed;  // true if woken by close() instead
+        bool queued;  // true while on the waiter list
+        WAITER* next;  // next waiter in FIFO order
+    };
+    priorityqueue<T> pq;  // elements nobody is waiting for yet
+    WAITER* head;  // oldest suspended consumer
+    WAITER* tail;  // newest suspended consumer
+    int waiting;  // # of suspended consumers
+    bool closed;  // true once close() has been called
+    function<void(coroutine_handle<>)> executor;  // empty means resume inline
+
+    // private helper function that takes the oldest waiter off the list
+    WAITER* popWaiter() {
+        WAITER* w = head;
+        head = w->next;
+        if (head == nullptr) {
+            tail = nullptr;
+        }
+        waiting--;
+        w->queued = false;
+        return w;
+    }
+    // private helper function that resumes a woken waiter, inline or
+    // through the executor
+    void wake(WAITER* w) {
+        if (executor) {
+            executor(w->handle);
+        } else {
+            w->handle.resume();
+        }
+    }
+ public:
+    //
+    // awaiter:
+    //
+    // Returned by async_dequeue().  co_await yields the next value.
+    //
+    class awaiter {
+     private:
+        asyncpriorityqueue* q;  // queue being awaited
+        WAITER w;  // this consumer's entry in the waiter list
+     public:
+        explicit awaiter(asyncpriorityqueue* queue) {
+            q = queue;
+            w.ready = false;
+            w.closed = false;
+            w.queued = false;
+            w.next = nullptr;
+        }
+        awaiter(const awaiter&) = delete;
+        awaiter& operator=(const awaiter&) = delete;
+        // the coroutine was destroyed while suspended, leave the list
+        ~awaiter() {
+            if (!w.queued) {
+                return;
+            }
+            WAITER* prev = nullptr;
+            WAITER* c = q->head;
+            while (c != &w) {
+                prev = c;
+                c = c->next;
+            }
+            if (prev == nullptr) {
+                q->head = w.next;
+            } else {
+                prev->next = w.next;
+            }
+            if (q->tail == &w) {
+                q->tail = prev;
+            }
+            q->waiting--;
+        }
+        // fast path: no suspension if an element is already queued, or
+        // nothing more will ever come
+        bool await_ready() {
+            return q->pq.Size() > 0 || q->closed;
+        }
+        void await_suspend(coroutine_handle<> h) {
+            w.handle = h;
+            w.queued = true;
+            if (q->tail == nullptr) {
+                q->head = &w;
+            } else {
+                q->tail->next = &w;
+            }
+            q->tail = &w;
+            q->waiting++;
+        }
+        optional<T> await_resume() {
+            if (w.ready) {
+                return w.value;
+            }
+            if (w.closed || q->pq.Size() == 0) {
+                // closed, and the queue may already be gone
+                return nullopt;
+            }
+            return q->pq.dequeue();
+        }
+    };
+
+    //
+    // default constructor:
+    //
+    // Creates an empty queue that resumes waiters inline on enqueue.
+    // O(1)
+    //
+    asyncpriorityqueue() {
+        head = nullptr;
+        tail = nullptr;
+        waiting = 0;
+        closed = false;
+    }
+    //
+    // executor constructor:
+    //
+    // Creates an empty queue that passes each woken waiter to exec instead
+    // of resuming it inline.  exec must eventually call resume() on it.
+    // O(1)
+    //
+    explicit asyncpriorityqueue(function<void(coroutine_handle<>)> exec) : asyncpriorityqueue() {
+        executor = exec;
+    }
+    //
+    // destructor:
+    //
+    // Closes the queue, so no waiter is left suspended on it.
+    // O(n + w), where n is the # of queued elements and w is the # of waiters
+    //
+    ~asyncpriorityqueue() {
+        close();
+    }
+    //
+    // enqueue:
+    //
+    // If a consumer is suspended, hands it the value directly and wakes it;
+    // otherwise inserts the value into the BST based on priority.  Returns
+    // false (and drops the value) if the queue has been closed.
+    // O(1) with a waiter, O(logn + m) otherwise
+    //
+    bool enqueue(T value, int priority) {
+        if (closed) {
+            return false;
+        }
+        if (head == nullptr) {
+            pq.enqueue(value, priority);
+            return true;
+        }
+        // the queue is empty whenever someone is waiting, so the oldest
+        // waiter gets this value regardless of priority
+        WAITER* w = popWaiter();
+        w->value = value;
+        w->ready = true;
+        wake(w);
+        return true;
+    }
+    //
+    // close:
+    //
+    // Rejects any further enqueue and wakes every waiter with nullopt.
+    // Elements already queued can still be dequeued.
+    // O(w), where w is the # of waiters
+    //
+    void close() {
+        closed = true;
+        while (head != nullptr) {
+            // a resumed waiter may destroy its frame, and w with it
+            WAITER* w = popWaiter();
+            w->closed = true;
+            wake(w);
+        }
+    }
+    //
+    // isClosed:
+    //
+    // Returns true once close() has been called.
+    // O(1)
+    //
+    bool isClosed() {
+        return closed;
+    }
+    //
+    // async_dequeue:
+    //
+    // Returns an awaitable for the next element.  co_await on it completes
+    // immediately if the queue is not empty or is closed, and suspends
+    // otherwise.  Yields nullopt once the queue is closed and drained.
+    // O(logn + m) when not suspending, O(1) to suspend
+    //
+    awaiter async_dequeue() {
+        return awaiter(this);
+    }
+    //
+    // Size:
+    //
+    // Returns the # of queued elements, 0 if empty.
+    // O(1)
+    //
+    int Size() {
+        return pq.Size();
+    }
+    //
+    // Waiting:
+    //
+    // Returns the # of consumers suspended in async_dequeue().
+    // O(1)
+    //
+    int Waiting() {
+        return waiting;
+    }
+};
@@ -0,0 +1,374 @@
+// bench.cpp
+//
+// Micro-benchmarks for the priority queue variants.  Build and run with
+// "make bench"; every section prints one line per configuration.
+#include <algorithm>
+#include <chrono>
+#include <coroutine>
+#include <cstdio>
+#include <malloc.h>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "priorityqueue.h"
+#include "blockingpriorityqueue.h"
+#include "asyncpriorityqueue.h"
+#include "compactpriorityqueue.h"
+#include "persistentpriorityqueue.h"
+#include "staticpriorityqueue.h"
+
+typedef chrono::steady_clock benchclock;
+
+// prints the mean, p50, p99, p99.9 and max of a set of samples in
+// microseconds
+static void report(const char* name, vector<double>& us) {
+    sort(us.begin(), us.end());
+    double sum = 0;
+    for (double u : us) sum += u;
+    printf("%-40s n=%-7zu mean=%9.3fus p50=%9.3fus p99=%9.3fus p99.9=%9.3fus max=%9.1fus\n",
+           name, us.size(), sum / us.size(), us[us.size() / 2],
+           us[us.size() * 99 / 100], us[us.size() * 999 / 1000], us.back());
+}
+
+static double elapsedUs(benchclock::time_point from, benchclock::time_point to) {
+    return chrono::duration<double, micro>(to - from).count();
+}
+
+//
+// wakeup latency: time from enqueue until a consumer has the item, for a
+// consumer polling Size() with a sleep versus one blocked in waitDequeue().
+//
+static void benchWakeupLatency() {
+    const int items = 2000;
+    vector<double> polled, blocked;
+
+    {
+        priorityqueue<benchclock::time_point> pq;
+        mutex m;
+        thread consumer([&] {
+            while ((int)polled.size() < items) {
+                m.lock();
+                if (pq.Size() > 0) {
+                    benchclock::time_point sent = pq.dequeue();
+                    m.unlock();
+                    polled.push_back(elapsedUs(sent, benchclock::now()));
+                    continue;
+                }
+                m.unlock();
+                this_thread::sleep_for(chrono::microseconds(100));
+            }
+        });
+        for (int i = 0; i < items; i++) {
+            m.lock();
+            pq.enqueue(benchclock::now(), i);
+            m.unlock();
+            this_thread::sleep_for(chrono::microseconds(200));
+        }
+        consumer.join();
+    }
+
+    {
+        blockingpriorityqueue<benchclock::time_point> bpq;
+        thread consumer([&] {
+            benchclock::time_point sent;
+            while (bpq.waitDequeue(sent)) {
+                blocked.push_back(elapsedUs(sent, benchclock::now()));
+            }
+        });
+        for (int i = 0; i < items; i++) {
+            bpq.enqueue(benchclock::now(), i);
+            this_thread::sleep_for(chrono::microseconds(200));
+        }
+        bpq.close();
+        consumer.join();
+    }
+
+    report("poll Size() + sleep(100us)", polled);
+    report("blockingpriorityqueue::waitDequeue", blocked);
+}
+
+//
+// deadline lateness: how long after its deadline a delayqueue item is
+// handed to one of several waiting consumers.
+//
+static void benchDelayLateness() {
+    const int items = 2000;
+    const int consumers = 4;
+    delayqueue<benchclock::time_point> dq;
+    vector<double> late[consumers];
+    vector<thread> threads;
+    for (int c = 0; c < consumers; c++) {
+        threads.push_back(thread([&, c] {
+            benchclock::time_point due;
+            while (dq.waitDequeue(due)) {
+                late[c].push_back(elapsedUs(due, benchclock::now()));
+            }
+        }));
+    }
+    benchclock::time_point start = benchclock::now();
+    for (int i = 0; i < items; i++) {
+        // spread deadlines out over ~1s, out of order
+        benchclock::time_point due = start + chrono::microseconds((i * 7919) % 1000000);
+        dq.enqueue(due, due);
+    }
+    this_thread::sleep_until(start + chrono::milliseconds(1100));
+    dq.close();
+    vector<double> all;
+    for (int c = 0; c < consumers; c++) {
+        threads[c].join();
+        all.insert(all.end(), late[c].begin(), late[c].end());
+    }
+    report("delayqueue lateness, 4 consumers", all);
+}
+
+// fire-and-forget coroutine type for the async benchmark
+struct detachedtask {
+    struct promise_type {
+        detachedtask get_return_object() { return {}; }
+        suspend_never initial_suspend() { return {}; }
+        suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { terminate(); }
+    };
+};
+
+static detachedtask asyncConsumer(asyncpriorityqueue<int>& apq, long long& sum) {
+    sum += *co_await apq.async_dequeue();
+}
+
+//
+// async handoff: suspend 100K consumer coroutines on an empty queue, then
+// wake them all through enqueue, inline and through an event loop.
+//
+static void benchAsyncHandoff() {
+    const int consumers = 100000;
+    for (int mode = 0; mode < 2; mode++) {
+        vector<coroutine_handle<>> ready;
+        ready.reserve(consumers);
+        asyncpriorityqueue<int> inlineQueue;
+        asyncpriorityqueue<int> loopQueue([&](coroutine_handle<> h) { ready.push_back(h); });
+        asyncpriorityqueue<int>& apq = (mode == 0) ? inlineQueue : loopQueue;
+        long long sum = 0;
+
+        benchclock::time_point start = benchclock::now();
+        for (int i = 0; i < consumers; i++) {
+            asyncConsumer(apq, sum);
+        }
+        benchclock::time_point suspended = benchclock::now();
+        for (int i = 0; i < consumers; i++) {
+            apq.enqueue(1, i);
+        }
+        for (coroutine_handle<> h : ready) {
+            h.resume();
+        }
+        benchclock::time_point resumed = benchclock::now();
+
+        printf("%-40s suspend=%6.1fns/op wake+resume=%6.1fns/op (sum=%lld)\n",
+               mode == 0 ? "async_dequeue 100K, resume inline" : "async_dequeue 100K, event loop",
+               elapsedUs(start, suspended) * 1000 / consumers,
+               elapsedUs(suspended, resumed) * 1000 / consumers, sum);
+    }
+}
+
+//
+// min/max throughput: random enqueues, then draining from either end.
+//
+static void benchMinMax() {
+    const int items = 1000000;
+    vector<int> priorities(items);
+    srand(28);
+    for (int i = 0; i < items; i++) {
+        priorities[i] = rand() % (items / 4);
+    }
+    for (int end = 0; end < 2; end++) {
+        priorityqueue<int> pq;
+        benchclock::time_point start = benchclock::now();
+        for (int i = 0; i < items; i++) {
+            pq.enqueue(i, priorities[i]);
+        }
+        benchclock::time_point filled = benchclock::now();
+        long long sum = 0;
+        for (int i = 0; i < items; i++) {
+            sum += (end == 0) ? pq.dequeue() : pq.dequeueMax();
+        }
+        benchclock::time_point drained = benchclock::now();
+        printf("%-40s enqueue=%6.1fns/op drain=%6.1fns/op (sum=%lld)\n",
+               end == 0 ? "priorityqueue 1M, dequeue" : "priorityqueue 1M, dequeueMax",
+               elapsedUs(start, filled) * 1000 / items,
+               elapsedUs(filled, drained) * 1000 / items, sum);
+    }
+}
+
+//
+// whole-queue operations: bulk build, copy, toString and clear of a 2M
+// element queue with 1 to 16 threads.
+//
+static void benchParallel() {
+    const int items = 2000000;
+    vector<pair<int, int>> range(items);
+    srand(29);
+    for (int i = 0; i < items; i++) {
+        range[i] = {i, rand() % items};
+    }
+    printf("(%u hardware threads)\n", thread::hardware_concurrency());
+    for (int threads = 1; threads <= 16; threads *= 2) {
+        benchclock::time_point t0 = benchclock::now();
+        priorityqueue<int> pq(range.begin(), range.end(), threads);
+        benchclock::time_point t1 = benchclock::now();
+        priorityqueue<int> copy;
+        copy.setThreads(threads);
+        copy = pq;
+        benchclock::time_point t2 = benchclock::now();
+        size_t length = copy.toString().size();
+        benchclock::time_point t3 = benchclock::now();
+        copy.clear();
+        benchclock::time_point t4 = benchclock::now();
+        printf("2M elements, %2d threads                  build=%7.1fms copy=%7.1fms toString=%7.1fms clear=%7.1fms (%zu chars)\n",
+               threads, elapsedUs(t0, t1) / 1000, elapsedUs(t1, t2) / 1000,
+               elapsedUs(t2, t3) / 1000, elapsedUs(t3, t4) / 1000, length);
+    }
+}
+
+// bytes currently allocated from the heap, including malloc's own headers.
+// Large blocks (like a reserved vector) are mmapped and counted separately.
+static size_t heapInUse() {
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+}
+
+//
+// memory footprint: heap bytes per element for 1M int elements, plus the
+// cost of a random enqueue/dequeue mix on the filled queue.
+//
+template<typename PQ>
+static void benchFootprint(const char* name, bool reserve) {
+    const int items = 1000000;
+    srand(30);
+    size_t before = heapInUse();
+    PQ* pq = new PQ();
+    if constexpr (requires { pq->reserve(items); }) {
+        if (reserve) pq->reserve(items);
+    }
+    for (int i = 0; i < items; i++) {
+        pq->enqueue(i, rand());
+    }
+    size_t after = heapInUse();
+    benchclock::time_point start = benchclock::now();
+    long long sum = 0;
+    for (int i = 0; i < items; i++) {
+        pq->enqueue(i, rand());
+        sum += pq->dequeue();
+    }
+    benchclock::time_point done = benchclock::now();
+    printf("%-40s bytes/element=%5.1f enqueue+dequeue=%6.1fns/op (sum=%lld)\n",
+           name, (double)(after - before) / items,
+           elapsedUs(start, done) * 1000 / items, sum);
+    delete pq;
+}
+
+//
+// snapshots: cost of a read-only copy of a 1M element queue via
+// operator= versus snapshot(), and what copy-on-write adds to writes.
+//
+static void benchSnapshot() {
+    const int items = 1000000;
+    const int writes = 200000;
+    priorityqueue<int> pq;
+    persistentpriorityqueue<int> ppq;
+    srand(31);
+    for (int i = 0; i < items; i++) {
+        int priority = rand();
+        pq.enqueue(i, priority);
+        ppq.enqueue(i, priority);
+    }
+
+    benchclock::time_point start = benchclock::now();
+    priorityqueue<int> copy;
+    copy = pq;
+    benchclock::time_point copied = benchclock::now();
+    persistentpriorityqueue<int>::view view = ppq.snapshot();
+    benchclock::time_point snapped = benchclock::now();
+    printf("%-40s operator=%9.1fus snapshot()=%9.3fus (%d, %d)\n", "read-only copy of 1M",
+           elapsedUs(start, copied), elapsedUs(copied, snapped), copy.Size(), view.Size());
+
+    for (int kind = 0; kind < 2; kind++) {
+        long long sum = 0;
+        start = benchclock::now();
+        for (int i = 0; i < writes; i++) {
+            int priority = rand();
+            if (kind == 0) {
+                pq.enqueue(i, priority);
+                sum += pq.dequeue();
+            } else {
+                ppq.enqueue(i, priority);
+                sum += ppq.dequeue();
+            }
+        }
+        benchclock::time_point done = benchclock::now();
+        printf("%-40s enqueue+dequeue=%6.1fns/op (sum=%lld)\n",
+               kind == 0 ? "priorityqueue 1M" : "persistentpriorityqueue 1M",
+               elapsedUs(start, done) * 1000 / writes, sum);
+    }
+
+    // duplicate-heavy: every enqueue lands on the same priority
+    const int dups = 20000;
+    for (int kind = 0; kind < 2; kind++) {
+        priorityqueue<int> dupPq;
+        persistentpriorityqueue<int> dupPpq;
+        start = benchclock::now();
+        for (int i = 0; i < dups; i++) {
+            if (kind == 0) {
+                dupPq.enqueue(i, 7);
+            } else {
+                dupPpq.enqueue(i, 7);
+            }
+        }
+        benchclock::time_point done = benchclock::now();
+        printf("%-40s enqueue=%6.1fns/op (%d)\n",
+               kind == 0 ? "priorityqueue 20K duplicates" : "persistentpriorityqueue 20K duplicates",
+               elapsedUs(start, done) * 1000 / dups, kind == 0 ? dupPq.Size() : dupPpq.Size());
+    }
+}
+
+//
+// hot-loop latency: per-operation enqueue+dequeue time on a queue holding
+// 1000 elements, dynamic versus fixed-capacity storage.
+//
+template<typename PQ>
+static void benchHotLoop(const char* name, PQ& pq) {
+    const int resident = 1000;
+    const int ops = 1000000;
+    vector<double> us;
+    us.reserve(ops);
+    srand(34);
+    for (int i = 0; i < resident; i++) {
+        pq.enqueue(i, rand() % 100000);
+    }
+    for (int i = 0; i < ops; i++) {
+        int priority = rand() % 100000;
+        benchclock::time_point start = benchclock::now();
+        pq.enqueue(i, priority);
+        pq.dequeue();
+        us.push_back(elapsedUs(start, benchclock::now()));
+    }
+    report(name, us);
+}
+
+static staticpriorityqueue<int, 1024> hotStatic;
+
+int main() {
+    benchWakeupLatency();
+    benchDelayLateness();
+    benchAsyncHandoff();
+    benchMinMax();
+    benchParallel();
+    benchFootprint<priorityqueue<int>>("priorityqueue 1M", false);
+    benchFootprint<compactpriorityqueue<int>>("compactpriorityqueue 1M", false);
+    benchFootprint<compactpriorityqueue<int>>("compactpriorityqueue 1M, reserved", true);
+    benchSnapshot();
+    priorityqueue<int> hotDynamic;
+    benchHotLoop("priorityqueue enqueue+dequeue", hotDynamic);
+    benchHotLoop("staticpriorityqueue enqueue+dequeue", hotStatic);
+    return 0;
+}
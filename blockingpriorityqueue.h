@@ -0,0 +1,316 @@
+// blockingpriorityqueue.h
+//
+// Thread-safe wrappers around priorityqueue for producer/consumer use.
+//
+// blockingpriorityqueue lets consumer threads block in waitDequeue() (or
+// tryDequeueFor() with a timeout) instead of spinning on Size().  Each
+// enqueue wakes at most one waiting consumer; close() wakes everyone so
+// they can shut down.
+//
+// delayqueue uses a steady_clock deadline as the priority, at the clock's
+// full resolution.  An item only
+// becomes dequeuable once its deadline has passed.  Only one consumer (the
+// "leader") sleeps on the earliest deadline; every other consumer waits
+// untimed until the leader hands the role over, so a deadline firing
+// never wakes more than one thread.
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "priorityqueue.h"
+
+template<typename T>
+class blockingpriorityqueue {
+ private:
+    priorityqueue<T> pq;  // underlying queue, guarded by m
+    mutex m;  // guards pq and closed
+    condition_variable notEmpty;  // signalled once per enqueue and on close
+    bool closed;  // true once close() has been called
+ public:
+    //
+    // default constructor:
+    //
+    // Creates an empty, open blocking priority queue.
+    // O(1)
+    //
+    blockingpriorityqueue() {
+        closed = false;
+    }
+    //
+    // enqueue:
+    //
+    // Inserts the value based on priority and wakes one waiting consumer.
+    // Returns false (and drops the value) if the queue has been closed.
+    // O(logn + m), see priorityqueue::enqueue
+    //
+    bool enqueue(T value, int priority) {
+        {
+            lock_guard<mutex> lock(m);
+            if (closed) {
+                return false;
+            }
+            pq.enqueue(value, priority);
+        }
+        // notify outside the lock so the woken consumer does not block on m
+        notEmpty.notify_one();
+        return true;
+    }
+    //
+    // tryDequeue:
+    //
+    // Removes the next element into value without blocking.  Returns false
+    // if the queue is empty.
+    // O(logn + m)
+    //
+    bool tryDequeue(T& value) {
+        lock_guard<mutex> lock(m);
+        if (pq.Size() == 0) {
+            return false;
+        }
+        value = pq.dequeue();
+        return true;
+    }
+    //
+    // waitDequeue:
+    //
+    // Blocks until an element is available and removes it into value.
+    // Returns false once the queue is closed and has been drained.
+    // O(logn + m) once woken
+    //
+    bool waitDequeue(T& value) {
+        unique_lock<mutex> lock(m);
+        notEmpty.wait(lock, [this] { return pq.Size() > 0 || closed; });
+        if (pq.Size() == 0) {
+            // closed and drained
+            return false;
+        }
+        value = pq.dequeue();
+        return true;
+    }
+    //
+    // tryDequeueFor:
+    //
+    // Like waitDequeue(), but gives up after timeout.  Returns false on
+    // timeout, or once the queue is closed and has been drained.
+    // O(logn + m) once woken
+    //
+    template<typename Rep, typename Period>
+    bool tryDequeueFor(T& value, const chrono::duration<Rep, Period>& timeout) {
+        unique_lock<mutex> lock(m);
+        if (!notEmpty.wait_for(lock, timeout, [this] { return pq.Size() > 0 || closed; })) {
+            // timed out
+            return false;
+        }
+        if (pq.Size() == 0) {
+            // closed and drained
+            return false;
+        }
+        value = pq.dequeue();
+        return true;
+    }
+    //
+    // close:
+    //
+    // Rejects any further enqueue and wakes every waiting consumer.  Items
+    // already in the queue can still be dequeued.
+    // O(1)
+    //
+    void close() {
+        {
+            lock_guard<mutex> lock(m);
+            closed = true;
+        }
+        notEmpty.notify_all();
+    }
+    //
+    // isClosed:
+    //
+    // Returns true once close() has been called.
+    // O(1)
+    //
+    bool isClosed() {
+        lock_guard<mutex> lock(m);
+        return closed;
+    }
+    //
+    // Size:
+    //
+    // Returns the # of elements in the queue, 0 if empty.
+    // O(1)
+    //
+    int Size() {
+        lock_guard<mutex> lock(m);
+        return pq.Size();
+    }
+};
+
+template<typename T>
+class delayqueue {
+ public:
+    typedef chrono::steady_clock clock;
+    typedef clock::time_point time_point;
+ private:
+    struct ITEM {
+        T value;  // stored data
+        time_point deadline;  // same as the priority, for peek()
+    };
+    priorityqueue<ITEM, time_point> pq;  // items ordered by deadline, guarded by m
+    mutex m;  // guards every member below
+    condition_variable available;  // signalled when the leader role is free
+    bool hasLeader;  // true while a consumer sleeps on the earliest deadline
+    thread::id leader;  // that consumer
+    bool closed;  // true once close() has been called
+
+    // private helper for the dequeue functions; m must be held.  Waits until
+    // the earliest item is due or until giveUp, whichever comes first.
+    // Returns true with the item in value, false on timeout or close.
+    bool take(unique_lock<mutex>& lock, T& value, time_point giveUp) {
+        bool result = false;
+        while (true) {
+            time_point now = clock::now();
+            if (pq.Size() > 0) {
+                ITEM head = pq.peek();
+                if (head.deadline <= now) {
+                    value = pq.dequeue().value;
+                    result = true;
+                    break;
+                }
+            }
+            if (closed || now >= giveUp) {
+                break;
+            }
+            if (pq.Size() == 0 || hasLeader) {
+                // nothing to time, or someone else is already timing it
+                if (giveUp == time_point::max()) {
+                    available.wait(lock);
+                } else {
+                    available.wait_until(lock, giveUp);
+                }
+            } else {
+                // become the leader and sleep on the earliest deadline
+                time_point wake = pq.peek().deadline;
+                if (giveUp < wake) wake = giveUp;
+                hasLeader = true;
+                leader = this_thread::get_id();
+                available.wait_until(lock, wake);
+                if (hasLeader && leader == this_thread::get_id()) {
+                    hasLeader = false;
+                }
+            }
+        }
+        // hand the leader role to one follower if there is more to wait for
+        if (!hasLeader && pq.Size() > 0 && !closed) {
+            available.notify_one();
+        }
+        return result;
+    }
+ public:
+    //
+    // default constructor:
+    //
+    // Creates an empty, open delay queue.
+    // O(1)
+    //
+    delayqueue() {
+        hasLeader = false;
+        closed = false;
+    }
+    //
+    // enqueue:
+    //
+    // Inserts the value to become available at deadline.  Only wakes a
+    // consumer when the new item is now the earliest one.  Returns false
+    // (and drops the value) if the queue has been closed.
+    // O(logn + m), see priorityqueue::enqueue
+    //
+    bool enqueue(T value, time_point deadline) {
+        bool earliest;
+        {
+            lock_guard<mutex> lock(m);
+            if (closed) {
+                return false;
+            }
+            pq.enqueue(ITEM{value, deadline}, deadline);
+            earliest = (pq.peek().deadline == deadline);
+            if (earliest) {
+                // the current leader is sleeping on a later deadline
+                hasLeader = false;
+            }
+        }
+        if (earliest) {
+            available.notify_one();
+        }
+        return true;
+    }
+    //
+    // enqueueAfter:
+    //
+    // Inserts the value to become available once delay has elapsed.
+    // O(logn + m)
+    //
+    template<typename Rep, typename Period>
+    bool enqueueAfter(T value, const chrono::duration<Rep, Period>& delay) {
+        return enqueue(value, clock::now() + chrono::duration_cast<clock::duration>(delay));
+    }
+    //
+    // tryDequeue:
+    //
+    // Removes the earliest item into value if its deadline has passed.
+    // Returns false without blocking otherwise.
+    // O(logn + m)
+    //
+    bool tryDequeue(T& value) {
+        unique_lock<mutex> lock(m);
+        return take(lock, value, time_point::min());
+    }
+    //
+    // waitDequeue:
+    //
+    // Blocks until the earliest item is due and removes it into value.
+    // Returns false once the queue has been closed and no item is due.
+    // O(logn + m) once woken
+    //
+    bool waitDequeue(T& value) {
+        unique_lock<mutex> lock(m);
+        return take(lock, value, time_point::max());
+    }
+    //
+    // tryDequeueFor:
+    //
+    // Like waitDequeue(), but gives up after timeout.  Returns false on
+    // timeout, or once the queue has been closed and no item is due.
+    // O(logn + m) once woken
+    //
+    template<typename Rep, typename Period>
+    bool tryDequeueFor(T& value, const chrono::duration<Rep, Period>& timeout) {
+        unique_lock<mutex> lock(m);
+        return take(lock, value, clock::now() + chrono::duration_cast<clock::duration>(timeout));
+    }
+    //
+    // close:
+    //
+    // Rejects any further enqueue and wakes every waiting consumer.  Items
+    // that are not yet due stay in the queue but are no longer waited for.
+    // O(1)
+    //
+    void close() {
+        {
+            lock_guard<mutex> lock(m);
+            closed = true;
+        }
+        available.notify_all();
+    }
+    //
+    // Size:
+    //
+    // Returns the # of items in the queue, due or not, 0 if empty.
+    // O(1)
+    //
+    int Size() {
+        lock_guard<mutex> lock(m);
+        return pq.Size();
+    }
+};
@@ -0,0 +1,123 @@
+// compactpriorityqueue.h
+//
+// A memory-compact version of priorityqueue with the same API and the same
+// complexity per operation.
+//
+// All nodes live in one vector and link to each other with 32-bit indices
+// instead of pointers, see indexedpriorityqueue.h.  That is 16 bytes plus
+// T per node, compared to ~56 bytes plus a malloc header per node in
+// priorityqueue.  The vector grows as needed, so enqueue never fails.
+// begin/next keep a stack of the O(logn) pending ancestors in place of the
+// parent links.
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "indexedpriorityqueue.h"
+
+using namespace std;
+
+// storage back end for compactpriorityqueue, one growable vector
+template<typename T>
+class vectornodes {
+ private:
+    vector<indexednode<T>> nodes;  // every node handed out so far
+ public:
+    indexednode<T>& operator[](uint32_t n) {
+        return nodes[n];
+    }
+    const indexednode<T>& operator[](uint32_t n) const {
+        return nodes[n];
+    }
+    uint32_t grow() {
+        nodes.push_back(indexednode<T>());
+        return nodes.size() - 1;
+    }
+    void reset() {
+        vector<indexednode<T>>().swap(nodes);
+    }
+    void reserve(int n) {
+        nodes.reserve(n);
+    }
+};
+
+template<typename T>
+class compactpriorityqueue : public indexedpriorityqueue<T, vectornodes<T>> {
+ private:
+    typedef indexedpriorityqueue<T, vectornodes<T>> base;
+    using base::NIL;
+    using base::nodes;
+    using base::root;
+    using base::curr;
+    vector<uint32_t> pending;  // ancestors still to visit (see begin and next)
+
+    // private helper function for begin() and next(), pushes n and its
+    // left spine onto the pending stack
+    void pushLeft(uint32_t n) {
+        while (n != NIL) {
+            pending.push_back(n);
+            n = nodes[n].left;
+        }
+    }
+ public:
+    //
+    // clear:
+    //
+    // Frees the memory associated with the priority queue.
+    // O(n), where n is total number of nodes in custom BST
+    //
+    void clear() {
+        base::clear();
+        vector<uint32_t>().swap(pending);
+    }
+    //
+    // reserve:
+    //
+    // Pre-allocates room for n elements so enqueue does not have to grow
+    // the node vector.
+    // O(n)
+    //
+    void reserve(int n) {
+        nodes.reserve(n);
+    }
+    //
+    // begin
+    //
+    // Resets internal state for an inorder traversal, see
+    // priorityqueue::begin.
+    // O(logn), where n is number of unique nodes in tree
+    //
+    void begin() {
+        pending.clear();
+        pushLeft(root);
+        curr = pending.empty() ? NIL : pending.back();
+    }
+    //
+    // next
+    //
+    // Returns the next inorder value/priority via the reference parameters
+    // and advances the internal state, see priorityqueue::next.
+    // O(1) amortized
+    //
+    bool next(T& value, int &priority) {
+        if (curr == NIL) {
+            // there is no more values/priorities to be given
+            priority = -999;
+            return false;
+        }
+        value = nodes[curr].value;
+        priority = nodes[curr].priority;
+        if (nodes[curr].link != NIL) {
+            // next duplicate
+            curr = nodes[curr].link;
+            return true;
+        }
+        // done with this tree node and its duplicates, visit its right subtree
+        uint32_t n = pending.back();
+        pending.pop_back();
+        pushLeft(nodes[n].right);
+        curr = pending.empty() ? NIL : pending.back();
+        return curr != NIL;
+    }
+};
@@ -0,0 +1,347 @@
+// indexedpriorityqueue.h
+//
+// The BST shared by compactpriorityqueue and staticpriorityqueue.
+//
+// Nodes link to each other with 32-bit indices into a storage back end
+// instead of pointers.  The per-node overhead is the priority plus three
+// links (left, right and the duplicate list), 16 bytes before T.  The
+// fields priorityqueue can derive are dropped:
+//   - dup: a node has duplicates exactly when its link is set.
+//   - parent: dequeue/dequeueMax remember the parent while walking down,
+//     and begin/next are left to the derived class.
+// Freed nodes go on a free list threaded through link and are reused by
+// later enqueues.  Since nodes are addressed by index, copies are plain
+// copies of the storage.
+//
+// STORAGE holds the indexednode<T>s and provides:
+//   - operator[](n): the node at index n
+//   - grow(): index of a node never used before, or INDEXNIL when full
+//   - reset(): forgets every node
+// Everything except toString() is constexpr, as far as STORAGE allows.
+#pragma once
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+constexpr uint32_t INDEXNIL = 0xFFFFFFFF;  // "null" index
+
+template<typename T>
+struct indexednode {
+    int priority = 0;  // used to build BST
+    uint32_t link = INDEXNIL;  // next duplicate, or next free node once freed
+    uint32_t left = INDEXNIL;  // index of left child
+    uint32_t right = INDEXNIL;  // index of right child
+    T value{};  // stored data for the p-queue
+};
+
+template<typename T, typename STORAGE>
+class indexedpriorityqueue {
+ protected:
+    static constexpr uint32_t NIL = INDEXNIL;
+    STORAGE nodes;  // storage for every node, used or free
+    uint32_t root;  // index of root node of the BST
+    uint32_t freeList;  // index of first free node
+    uint32_t maxNode;  // index of node with the largest priority
+    int size;  // # of elements in the pqueue
+    uint32_t curr;  // next item in pqueue (see begin and next)
+
+    // private helper function that takes a node off the free list, or a
+    // new one from the storage, returns NIL when full
+    constexpr uint32_t allocate(T value, int priority) {
+        uint32_t n = freeList;
+        if (n != NIL) {
+            freeList = nodes[n].link;
+        } else {
+            n = nodes.grow();
+            if (n == NIL) {
+                return NIL;
+            }
+        }
+        nodes[n].priority = priority;
+        nodes[n].link = NIL;
+        nodes[n].left = NIL;
+        nodes[n].right = NIL;
+        nodes[n].value = value;
+        return n;
+    }
+    // private helper function that puts a node on the free list
+    constexpr void release(uint32_t n) {
+        nodes[n].value = T();
+        nodes[n].link = freeList;
+        freeList = n;
+    }
+    // private helper function that puts replacement where n used to be
+    // under parent (or at the root)
+    constexpr void replaceChild(uint32_t parent, uint32_t n, uint32_t replacement) {
+        if (parent == NIL) {
+            root = replacement;
+        } else if (nodes[parent].left == n) {
+            nodes[parent].left = replacement;
+        } else {
+            nodes[parent].right = replacement;
+        }
+    }
+    // private helper function for toString() method
+    void inOrder(uint32_t n, stringstream& ss) const {
+        if (n == NIL) return;
+        inOrder(nodes[n].left, ss);
+        // the node and then each of its duplicates
+        for (uint32_t c = n; c != NIL; c = nodes[c].link) {
+            ss << nodes[c].priority << " value: " << nodes[c].value << endl;
+        }
+        inOrder(nodes[n].right, ss);
+    }
+    // private helper function for operator==
+    constexpr bool equal(uint32_t cur, const indexedpriorityqueue& other, uint32_t otherCur) const {
+        if (cur == NIL || otherCur == NIL) {
+            return cur == otherCur;
+        }
+        // compare the node and its duplicates
+        uint32_t c = cur;
+        uint32_t oC = otherCur;
+        while (c != NIL && oC != NIL) {
+            if (nodes[c].value != other.nodes[oC].value) {
+                return false;
+            }
+            c = nodes[c].link;
+            oC = other.nodes[oC].link;
+        }
+        if (c != oC) {
+            // one list of duplicates is longer
+            return false;
+        }
+        return equal(nodes[cur].left, other, other.nodes[otherCur].left) &&
+               equal(nodes[cur].right, other, other.nodes[otherCur].right);
+    }
+ public:
+    //
+    // default constructor:
+    //
+    // Creates an empty priority queue.
+    // O(1), plus whatever STORAGE needs
+    //
+    constexpr indexedpriorityqueue() : nodes() {
+        root = NIL;
+        freeList = NIL;
+        maxNode = NIL;
+        size = 0;
+        curr = NIL;
+    }
+    //
+    // clear:
+    //
+    // Removes every element and hands the nodes back to the storage.
+    // O(n), where n is total number of nodes in custom BST
+    //
+    constexpr void clear() {
+        nodes.reset();
+        root = NIL;
+        freeList = NIL;
+        maxNode = NIL;
+        size = 0;
+        curr = NIL;
+    }
+    //
+    // tryEnqueue:
+    //
+    // Inserts the value into the custom BST in the correct location based on
+    // priority.  Returns false, leaving the queue unchanged, if the storage
+    // is full.
+    // O(logn + m), where n is number of unique nodes in tree and m is number of
+    // duplicate priorities
+    //
+    constexpr bool tryEnqueue(T value, int priority) {
+        uint32_t newNode = allocate(value, priority);
+        if (newNode == NIL) {
+            return false;
+        }
+        size++;
+        if (root == NIL) {
+            root = newNode;
+            maxNode = newNode;
+            return true;
+        }
+        uint32_t prev = NIL;
+        uint32_t cur = root;
+        while (cur != NIL) {
+            if (priority == nodes[cur].priority) {
+                // append to the end of the list of duplicates
+                while (nodes[cur].link != NIL) {
+                    cur = nodes[cur].link;
+                }
+                nodes[cur].link = newNode;
+                return true;
+            }
+            prev = cur;
+            cur = (priority < nodes[cur].priority) ? nodes[cur].left : nodes[cur].right;
+        }
+        if (priority < nodes[prev].priority) {
+            nodes[prev].left = newNode;
+        } else {
+            nodes[prev].right = newNode;
+        }
+        if (priority > nodes[maxNode].priority) {
+            maxNode = newNode;
+        }
+        return true;
+    }
+    //
+    // enqueue:
+    //
+    // Same as tryEnqueue(), but the value is silently dropped when the
+    // storage is full.
+    // O(logn + m)
+    //
+    constexpr void enqueue(T value, int priority) {
+        tryEnqueue(value, priority);
+    }
+    //
+    // dequeue:
+    //
+    // returns the value of the next element in the priority queue and removes
+    // the element from the priority queue.
+    // O(logn), where n is number of unique nodes in tree
+    //
+    constexpr T dequeue() {
+        if (root == NIL) {
+            // tree is empty
+            return {};
+        }
+        // traverse to leftmost node, remembering its parent
+        uint32_t parent = NIL;
+        uint32_t c = root;
+        while (nodes[c].left != NIL) {
+            parent = c;
+            c = nodes[c].left;
+        }
+        T valueOut = nodes[c].value;
+        uint32_t next = nodes[c].link;
+        if (next != NIL) {
+            // the next duplicate takes c's place in the tree
+            nodes[next].right = nodes[c].right;
+            replaceChild(parent, c, next);
+            if (maxNode == c) {
+                maxNode = next;
+            }
+        } else {
+            // the right subtree takes c's place in the tree
+            replaceChild(parent, c, nodes[c].right);
+            if (maxNode == c) {
+                // c was the root and had no right subtree
+                maxNode = NIL;
+            }
+        }
+        release(c);
+        size--;
+        return valueOut;
+    }
+    //
+    // dequeueMax:
+    //
+    // returns the value of the element with the largest priority and removes
+    // it from the priority queue.  Among duplicates this is the first one
+    // enqueued.
+    // O(logn), where n is number of unique nodes in tree
+    //
+    constexpr T dequeueMax() {
+        if (root == NIL) {
+            // tree is empty
+            return {};
+        }
+        // traverse to rightmost node, remembering its parent
+        uint32_t parent = NIL;
+        uint32_t c = root;
+        while (nodes[c].right != NIL) {
+            parent = c;
+            c = nodes[c].right;
+        }
+        T valueOut = nodes[c].value;
+        uint32_t next = nodes[c].link;
+        if (next != NIL) {
+            // the next duplicate takes c's place in the tree
+            nodes[next].left = nodes[c].left;
+            replaceChild(parent, c, next);
+            maxNode = next;
+        } else {
+            // the left subtree takes c's place in the tree
+            uint32_t l = nodes[c].left;
+            replaceChild(parent, c, l);
+            if (l != NIL) {
+                maxNode = l;
+                while (nodes[maxNode].right != NIL) {
+                    maxNode = nodes[maxNode].right;
+                }
+            } else {
+                maxNode = parent;
+            }
+        }
+        release(c);
+        size--;
+        return valueOut;
+    }
+    //
+    // Size:
+    //
+    // Returns the # of elements in the priority queue, 0 if empty.
+    // O(1)
+    //
+    constexpr int Size() const {
+        return size;
+    }
+    //
+    // toString:
+    //
+    // Returns a string of the entire priority queue, in order, in the same
+    // format as priorityqueue::toString.
+    //
+    string toString() const {
+        stringstream ss;
+        inOrder(root, ss);
+        return ss.str();
+    }
+    //
+    // peek:
+    //
+    // returns the value of the next element in the priority queue but does not
+    // remove the item from the priority queue.
+    // O(logn), where n is number of unique nodes in tree
+    //
+    constexpr T peek() const {
+        if (root == NIL) {
+            // tree is empty
+            return {};
+        }
+        uint32_t c = root;
+        while (nodes[c].left != NIL) {
+            c = nodes[c].left;
+        }
+        return nodes[c].value;
+    }
+    //
+    // peekMax:
+    //
+    // returns the value of the element with the largest priority but does not
+    // remove it.  Among duplicates this is the first one enqueued.
+    // O(1)
+    //
+    constexpr T peekMax() const {
+        if (maxNode == NIL) {
+            // tree is empty
+            return {};
+        }
+        return nodes[maxNode].value;
+    }
+    //
+    // ==operator
+    //
+    // Returns true if this priority queue has the same shape and values as
+    // the priority queue passed in as other.  Otherwise returns false.
+    // O(n), where n is total number of nodes in custom BST
+    //
+    constexpr bool operator==(const indexedpriorityqueue& other) const {
+        return equal(root, other, other.root);
+    }
+};
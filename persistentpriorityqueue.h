@@ -0,0 +1,340 @@
+// persistentpriorityqueue.h
+//
+// A copy-on-write priority queue whose snapshots are O(1).
+//
+// Nodes are immutable once built and are shared through shared_ptr.  A
+// write never changes a node: it copies the nodes on the path from the
+// root to the node it touches and publishes the new root.  Everything
+// else is shared with older versions.
+//
+// Duplicates are ordinary BST nodes: the tree is ordered by (priority,
+// enqueue #), so equal priorities still come out FIFO.  To keep every
+// path O(logn), even for long runs of one priority, the tree is a treap
+// whose heap key is a hash of the enqueue #.  Since the hash is fixed,
+// the same sequence of writes always gives the same shape.  snapshot() just grabs the current root, so it costs O(1) and
+// the returned view never changes, no matter what the queue does next.
+//
+// Writes are meant to come from one thread, as with priorityqueue.  The
+// root is an atomic shared_ptr, so snapshot() can be called from any
+// thread while the writer is running, and views can be read from any
+// thread.  Each node also keeps the # of elements in its subtree, so the
+// root holds Size() and a view needs nothing beyond its root.
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+template<typename T>
+class persistentpriorityqueue {
+ private:
+    struct NODE {
+        int priority;  // used to build BST
+        uint64_t seq;  // enqueue #, orders equal priorities
+        T value;  // stored data for the p-queue
+        int count;  // # of elements in this subtree
+        shared_ptr<const NODE> left;  // links to left child
+        shared_ptr<const NODE> right;  // links to right child
+    };
+    typedef shared_ptr<const NODE> NODEPTR;
+    atomic<NODEPTR> root;  // current version of the BST
+    uint64_t nextSeq;  // seq for the next enqueue, only used by the writer
+
+    // private helper function, the treap heap key of a node: a mix of its
+    // seq (splitmix64), so the treap is balanced as if keys were random
+    static uint64_t rank(const NODE* n) {
+        uint64_t x = n->seq + 0x9E3779B97F4A7C15ULL;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
+    }
+    static int countOf(const NODEPTR& n) {
+        return (n == nullptr) ? 0 : n->count;
+    }
+    // private helper function for enqueue(), copies the path to where the
+    // new node goes and rotates it up while its rank is higher.  Every
+    // node returned is a fresh copy, so rotating never touches a node an
+    // older version can see.
+    static shared_ptr<NODE> insert(const NODEPTR& n, const T& value, int priority, uint64_t seq) {
+        if (n == nullptr) {
+            shared_ptr<NODE> fresh = make_shared<NODE>();
+            fresh->priority = priority;
+            fresh->seq = seq;
+            fresh->value = value;
+            fresh->count = 1;
+            return fresh;
+        }
+        shared_ptr<NODE> copy = make_shared<NODE>(*n);
+        copy->count++;
+        // seq is the largest so far, so ties go right
+        if (priority < n->priority) {
+            shared_ptr<NODE> l = insert(n->left, value, priority, seq);
+            if (rank(l.get()) > rank(copy.get())) {
+                // rotate right
+                copy->left = l->right;
+                copy->count = 1 + countOf(copy->left) + countOf(copy->right);
+                l->right = copy;
+                l->count = 1 + countOf(l->left) + copy->count;
+                return l;
+            }
+            copy->left = l;
+        } else {
+            shared_ptr<NODE> r = insert(n->right, value, priority, seq);
+            if (rank(r.get()) > rank(copy.get())) {
+                // rotate left
+                copy->right = r->left;
+                copy->count = 1 + countOf(copy->left) + countOf(copy->right);
+                r->left = copy;
+                r->count = 1 + copy->count + countOf(r->right);
+                return r;
+            }
+            copy->right = r;
+        }
+        return copy;
+    }
+    // private helper function for dequeue(), copies the path to the
+    // leftmost node and removes it
+    static NODEPTR removeMin(const NODEPTR& n, T& valueOut) {
+        if (n->left == nullptr) {
+            // the right subtree takes n's place, heap order still holds
+            valueOut = n->value;
+            return n->right;
+        }
+        shared_ptr<NODE> copy = make_shared<NODE>(*n);
+        copy->count--;
+        copy->left = removeMin(n->left, valueOut);
+        return copy;
+    }
+ public:
+    //
+    // view:
+    //
+    // An immutable snapshot of the queue, see snapshot().  Views are cheap
+    // to copy and stay valid after the queue changes or is destroyed.
+    //
+    class view {
+     private:
+        friend class persistentpriorityqueue;
+        NODEPTR root;  // version of the BST this view sees
+        const NODE* curr;  // next item (see begin and next)
+        vector<const NODE*> pending;  // ancestors still to visit (see begin and next)
+
+        explicit view(NODEPTR r) {
+            root = r;
+            curr = nullptr;
+        }
+        // private helper function for begin() and next()
+        void pushLeft(const NODE* n) {
+            while (n != nullptr) {
+                pending.push_back(n);
+                n = n->left.get();
+            }
+        }
+        // private helper function for toString() method
+        static void inOrder(const NODE* n, stringstream& ss) {
+            if (n == nullptr) return;
+            inOrder(n->left.get(), ss);
+            ss << n->priority << " value: " << n->value << endl;
+            inOrder(n->right.get(), ss);
+        }
+        // private helper function for operator==
+        static bool equal(const NODE* cur, const NODE* otherCur) {
+            if (cur == otherCur) {
+                // same node, or both empty; shared subtrees are equal
+                return true;
+            }
+            if (cur == nullptr || otherCur == nullptr || cur->count != otherCur->count) {
+                return false;
+            }
+            return cur->value == otherCur->value &&
+                   equal(cur->left.get(), otherCur->left.get()) &&
+                   equal(cur->right.get(), otherCur->right.get());
+        }
+     public:
+        //
+        // default constructor:
+        //
+        // Creates a view of an empty queue.
+        // O(1)
+        //
+        view() {
+            curr = nullptr;
+        }
+        //
+        // Size:
+        //
+        // Returns the # of elements in the snapshot, 0 if empty.
+        // O(1)
+        //
+        int Size() const {
+            return (root == nullptr) ? 0 : root->count;
+        }
+        //
+        // begin
+        //
+        // Resets internal state for an inorder traversal, see
+        // priorityqueue::begin.
+        // O(logn) expected, where n is number of elements in tree
+        //
+        void begin() {
+            pending.clear();
+            pushLeft(root.get());
+            curr = pending.empty() ? nullptr : pending.back();
+        }
+        //
+        // next
+        //
+        // Returns the next inorder value/priority via the reference
+        // parameters, see priorityqueue::next.
+        // O(1) amortized
+        //
+        bool next(T& value, int &priority) {
+            if (curr == nullptr) {
+                // there is no more values/priorities to be given
+                priority = -999;
+                return false;
+            }
+            value = curr->value;
+            priority = curr->priority;
+            // done with this tree node, visit its right subtree
+            const NODE* n = pending.back();
+            pending.pop_back();
+            pushLeft(n->right.get());
+            curr = pending.empty() ? nullptr : pending.back();
+            return curr != nullptr;
+        }
+        //
+        // toString:
+        //
+        // Returns a string of the entire snapshot, in order, in the same
+        // format as priorityqueue::toString.
+        //
+        string toString() const {
+            stringstream ss;
+            inOrder(root.get(), ss);
+            return ss.str();
+        }
+        //
+        // ==operator
+        //
+        // Returns true if both snapshots have the same shape and values.
+        // Subtrees shared between the two are not visited.
+        // O(n) worst case, O(1) for two snapshots of the same version
+        //
+        bool operator==(const view& other) const {
+            return equal(root.get(), other.root.get());
+        }
+    };
+
+    //
+    // default constructor:
+    //
+    // Creates an empty priority queue.
+    // O(1)
+    //
+    persistentpriorityqueue() {
+        root.store(nullptr);
+        nextSeq = 0;
+    }
+    //
+    // clear:
+    //
+    // Empties the queue.  Nodes still referenced by snapshots are kept
+    // alive by them.
+    // O(n) for nodes no snapshot shares, O(1) otherwise
+    //
+    void clear() {
+        root.store(nullptr);
+        nextSeq = 0;
+    }
+    //
+    // enqueue:
+    //
+    // Inserts the value based on priority, after any equal priorities,
+    // copying only the nodes on the path to it.
+    // O(logn) expected, where n is number of elements in tree
+    //
+    void enqueue(T value, int priority) {
+        root.store(insert(root.load(), value, priority, nextSeq++));
+    }
+    //
+    // dequeue:
+    //
+    // returns the value of the next element in the priority queue and removes
+    // the element, copying only the nodes on the path to it.
+    // O(logn) expected, where n is number of elements in tree
+    //
+    T dequeue() {
+        NODEPTR r = root.load();
+        T valueOut;
+        if (r == nullptr) {
+            // tree is empty
+            return {};
+        }
+        root.store(removeMin(r, valueOut));
+        return valueOut;
+    }
+    //
+    // peek:
+    //
+    // returns the value of the next element in the priority queue but does not
+    // remove the item from the priority queue.
+    // O(logn) expected, where n is number of elements in tree
+    //
+    T peek() {
+        NODEPTR r = root.load();
+        if (r == nullptr) {
+            // tree is empty
+            return {};
+        }
+        const NODE* c = r.get();
+        while (c->left != nullptr) {
+            c = c->left.get();
+        }
+        return c->value;
+    }
+    //
+    // Size:
+    //
+    // Returns the # of elements in the priority queue, 0 if empty.
+    // O(1)
+    //
+    int Size() {
+        NODEPTR r = root.load();
+        return (r == nullptr) ? 0 : r->count;
+    }
+    //
+    // snapshot:
+    //
+    // Returns an immutable view of the queue as it is right now.  May be
+    // called from any thread.
+    // O(1)
+    //
+    view snapshot() const {
+        return view(root.load());
+    }
+    //
+    // toString:
+    //
+    // Returns a string of the entire priority queue, in order, in the same
+    // format as priorityqueue::toString.
+    //
+    string toString() const {
+        return snapshot().toString();
+    }
+    //
+    // ==operator
+    //
+    // Returns true if this priority queue has the same shape and values as
+    // the priority queue passed in as other.  Otherwise returns false.
+    // O(n), where n is total number of nodes in custom BST
+    //
+    bool operator==(const persistentpriorityqueue& other) const {
+        return snapshot() == other.snapshot();
+    }
+};
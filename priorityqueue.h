@@ -7,29 +7,167 @@
 #include <iostream>
 #include <sstream>
 #include <set>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <type_traits>
+#include <iterator>
 
 using namespace std;
 
-template<typename T>
+// P is the priority type.  Anything with the usual comparison operators
+// works, e.g. a chrono time_point.
+template<typename T, typename P = int>
 class priorityqueue {
  private:
     struct NODE {
-        int priority;  // used to build BST
+        P priority;  // used to build BST
         T value;  // stored data for the p-queue
         bool dup;  // marked true when there are duplicate priorities
         NODE* parent;  // links back to parent
         NODE* link;  // links to linked list of NODES with duplicate priorities
         NODE* left;  // links to left child
         NODE* right;  // links to right child
+        int count;  // # of elements in this subtree, duplicates included
     };
     NODE* root;  // pointer to root node of the BST
     int size;  // # of elements in the pqueue
     NODE* curr;  // pointer to next item in pqueue (see begin and next)
-    // private helper function for toString() method
-    void inOrder(NODE* n, stringstream& ss) {
-        if (n == nullptr) return;
-        // first go left
-        inOrder(n->left, ss);
+    NODE* maxNode;  // pointer to node with the largest priority (see peekMax)
+    int threads;  // max # of threads used by whole-queue operations
+    // whole-queue operations below take a thread budget: the # of threads,
+    // including the caller's, they may run at once.  Splitting at a node
+    // hands the left subtree half the budget on a new thread.
+    // private helper function to find the node with the largest priority
+    NODE* rightmost(NODE* n) const {
+        if (n == nullptr) return nullptr;
+        while (n->right != nullptr) {
+            n = n->right;
+        }
+        return n;
+    }
+    // private helper function, # of elements in the subtree at n
+    static int countOf(NODE* n) {
+        return (n == nullptr) ? 0 : n->count;
+    }
+    // private helper function for countRange(), # of elements with a
+    // priority below p (or at most p when inclusive)
+    int countBelow(const P& p, bool inclusive) const {
+        int result = 0;
+        NODE* n = root;
+        while (n != nullptr) {
+            if (n->priority < p || (inclusive && n->priority == p)) {
+                // n, its duplicates and its left subtree all count
+                result += n->count - countOf(n->right);
+                n = n->right;
+            } else {
+                n = n->left;
+            }
+        }
+        return result;
+    }
+    // private helper function that splits the subtree at n into the
+    // elements with priorities below p, or at most p when inclusive, (less)
+    // and the rest (rest).  Only the nodes on one root-to-leaf path are
+    // relinked; duplicate lists move with their node.
+    void splitTree(NODE* n, const P& p, bool inclusive, NODE*& less, NODE*& rest) {
+        if (n == nullptr) {
+            less = nullptr;
+            rest = nullptr;
+            return;
+        }
+        int dups = n->count - countOf(n->left) - countOf(n->right);
+        if (n->priority < p || (inclusive && n->priority == p)) {
+            // n and its left subtree go to less
+            splitTree(n->right, p, inclusive, n->right, rest);
+            if (n->right != nullptr) {
+                n->right->parent = n;
+            }
+            less = n;
+        } else {
+            // n and its right subtree go to rest
+            splitTree(n->left, p, inclusive, less, n->left);
+            if (n->left != nullptr) {
+                n->left->parent = n;
+            }
+            rest = n;
+        }
+        n->count = dups + countOf(n->left) + countOf(n->right);
+        n->parent = nullptr;
+    }
+    // private helper function that joins two subtrees where every priority
+    // in less is below every priority in rest, returns the new root.  The
+    // smallest node of rest becomes the root with less on its left, so the
+    // result is only one level deeper than the deeper of the two.
+    NODE* joinTrees(NODE* less, NODE* rest) {
+        if (less == nullptr) return rest;
+        if (rest == nullptr) return less;
+        // detach the leftmost node of rest, every subtree on the way loses
+        // it and its duplicates
+        NODE* m = rest;
+        while (m->left != nullptr) {
+            m = m->left;
+        }
+        int dups = m->count - countOf(m->right);
+        for (NODE* a = m->parent; a != nullptr; a = a->parent) {
+            a->count -= dups;
+        }
+        if (m == rest) {
+            rest = m->right;
+        } else {
+            m->parent->left = m->right;
+        }
+        if (m->right != nullptr) {
+            m->right->parent = m->parent;
+        }
+        // m takes less and what is left of rest as its children
+        m->left = less;
+        m->right = rest;
+        less->parent = m;
+        if (rest != nullptr) {
+            rest->parent = m;
+        }
+        m->parent = nullptr;
+        m->count = dups + countOf(less) + countOf(rest);
+        return m;
+    }
+    // private helper function for extractRange() and eraseRange(), takes
+    // the elements with priorities in [lo, hi] out of the BST and returns
+    // them as a separate subtree
+    NODE* cutRange(const P& lo, const P& hi) {
+        NODE* less = nullptr;
+        NODE* rest = nullptr;
+        NODE* middle = nullptr;
+        NODE* greater = nullptr;
+        splitTree(root, lo, false, less, rest);
+        splitTree(rest, hi, true, middle, greater);
+        root = joinTrees(less, greater);
+        size -= countOf(middle);
+        maxNode = rightmost(root);
+        // cutting the tree invalidates any traversal in progress
+        curr = nullptr;
+        return middle;
+    }
+    // private helper function for extractRange(), moves the elements of
+    // the subtree at n into out in order and frees the nodes
+    void extractInOrder(NODE* n, vector<pair<T, P>>& out) {
+        if (n == nullptr) {
+            return;
+        }
+        extractInOrder(n->left, out);
+        NODE* right = n->right;
+        NODE* c = n;
+        while (c != nullptr) {
+            NODE* next = c->link;
+            out.push_back({c->value, c->priority});
+            delete c;
+            c = next;
+        }
+        extractInOrder(right, out);
+    }
+    // private helper function to write one node and its duplicates
+    void writeNode(NODE* n, stringstream& ss) {
         // get data of node
         ss << n->priority << " value: " << n->value << endl;
         // check for duplicates
@@ -41,18 +179,45 @@ class priorityqueue {
                 c = c->link;
             }
         }
+    }
+    // private helper function for toString() method
+    void inOrder(NODE* n, stringstream& ss) {
+        if (n == nullptr) return;
+        // first go left
+        inOrder(n->left, ss);
+        writeNode(n, ss);
         // go right
         inOrder(n->right, ss);
     }
+    // private helper function for toString(), lists the subtree at n in
+    // order as at most budget whole subtrees (true) and the nodes above
+    // them (false)
+    void splitWork(NODE* n, int budget, vector<pair<NODE*, bool>>& pieces) {
+        if (n == nullptr) return;
+        if (budget <= 1) {
+            pieces.push_back({n, true});
+            return;
+        }
+        splitWork(n->left, budget / 2, pieces);
+        pieces.push_back({n, false});
+        splitWork(n->right, budget - budget / 2, pieces);
+    }
     // private helper function for clear() method
-    void postOrderDelete(NODE* n) {
+    void postOrderDelete(NODE* n, int budget) {
         if (n == nullptr) {
             return;
         }
-        // go through left subtrees
-        postOrderDelete(n->left);
-        // go through right subtrees
-        postOrderDelete(n->right);
+        if (budget > 1 && n->left != nullptr) {
+            // delete the left subtree on another thread
+            thread t(&priorityqueue::postOrderDelete, this, n->left, budget / 2);
+            postOrderDelete(n->right, budget - budget / 2);
+            t.join();
+        } else {
+            // go through left subtrees
+            postOrderDelete(n->left, budget);
+            // go through right subtrees
+            postOrderDelete(n->right, budget);
+        }
         // deal with node
         // first check if node has duplicates
         if (n->dup) {
@@ -68,25 +233,161 @@ class priorityqueue {
         // delete the node
         delete n;
     }
-    // private helper function for operator= method
-    void preOrderCopy(NODE* n) {
+    // private helper function that appends a duplicate to the end of the
+    // list starting at tail, returns the new tail
+    NODE* appendDup(NODE* tail, const T& value) {
+        NODE* newNode = new NODE;
+        newNode->priority = tail->priority;
+        newNode->value = value;
+        newNode->dup = true;
+        newNode->parent = tail;
+        newNode->link = nullptr;
+        newNode->left = nullptr;
+        newNode->right = nullptr;
+        newNode->count = 1;
+        tail->link = newNode;
+        return newNode;
+    }
+    // private helper function for operator= method, copies the subtree at
+    // n node for node so the copy has the same shape
+    NODE* preOrderCopy(NODE* n, NODE* parent, int budget) {
         if (n == nullptr) {
-            return;
+            return nullptr;
         }
         // copy node
-        enqueue(n->value, n->priority);
-        // check for duplicates
-        if (n->dup) {
-            NODE* c = n->link;
-            while (c != nullptr) {
-                enqueue(c->value, c->priority);
-                c = c->link;
+        NODE* copy = new NODE;
+        copy->priority = n->priority;
+        copy->value = n->value;
+        copy->dup = n->dup;
+        copy->parent = parent;
+        copy->link = nullptr;
+        copy->left = nullptr;
+        copy->right = nullptr;
+        copy->count = n->count;
+        // copy duplicates
+        NODE* tail = copy;
+        NODE* c = n->link;
+        while (c != nullptr) {
+            tail = appendDup(tail, c->value);
+            c = c->link;
+        }
+        if (budget > 1 && n->left != nullptr) {
+            // copy the left subtree on another thread
+            thread t([&] { copy->left = preOrderCopy(n->left, copy, budget / 2); });
+            copy->right = preOrderCopy(n->right, copy, budget - budget / 2);
+            t.join();
+        } else {
+            // go through left subtree
+            copy->left = preOrderCopy(n->left, copy, budget);
+            // go through right subtree
+            copy->right = preOrderCopy(n->right, copy, budget);
+        }
+        return copy;
+    }
+    // private helper function for build(), splits [0, n) into one chunk
+    // per thread (or a single chunk when n is small) and runs
+    // body(chunk, lo, hi) on each chunk in parallel; returns # of chunks
+    template<typename F>
+    int parallelChunks(size_t n, F body) {
+        int chunks = (threads <= 1 || n < (size_t)threads * 2) ? 1 : threads;
+        vector<thread> workers;
+        for (int i = 1; i < chunks; i++) {
+            workers.push_back(thread(body, i, n * i / chunks, n * (i + 1) / chunks));
+        }
+        body(0, 0, n / chunks);
+        for (thread& t : workers) t.join();
+        return chunks;
+    }
+    // private helper function for build(), stable sorts items by priority
+    // by sorting one chunk per thread and then merging neighbouring runs.
+    // Each merge round is split across every thread as well: a run's
+    // left half is cut into pieces and each piece, with the part of the
+    // right half that falls between its ends, is merged on its own thread.
+    void parallelSort(vector<pair<P, T>>& items) {
+        auto byPriority = [](const pair<P, T>& a, const pair<P, T>& b) {
+            return a.first < b.first;
+        };
+        size_t n = items.size();
+        vector<size_t> bounds;
+        int chunks = parallelChunks(n, [&](int, size_t lo, size_t hi) {
+            stable_sort(items.begin() + lo, items.begin() + hi, byPriority);
+        });
+        if (chunks == 1) {
+            return;
+        }
+        for (int i = 0; i <= chunks; i++) {
+            bounds.push_back(n * i / chunks);
+        }
+        // each round halves the number of sorted runs, moving them back and
+        // forth between items and buffer
+        vector<pair<P, T>> buffer(n);
+        vector<pair<P, T>>* from = &items;
+        vector<pair<P, T>>* to = &buffer;
+        vector<thread> workers;
+        for (int width = 1; width < chunks; width *= 2) {
+            int merges = (chunks + 2 * width - 1) / (2 * width);
+            int pieces = max(1, threads / merges);
+            workers.clear();
+            for (int i = 0; i < chunks; i += 2 * width) {
+                auto src = from->begin();
+                size_t aLo = bounds[i];
+                size_t mid = bounds[min(i + width, chunks)];
+                size_t bHi = bounds[min(i + 2 * width, chunks)];
+                for (int k = 0; k < pieces; k++) {
+                    size_t a0 = aLo + (mid - aLo) * k / pieces;
+                    size_t a1 = aLo + (mid - aLo) * (k + 1) / pieces;
+                    // right-half elements below a piece's first priority
+                    // belong to an earlier piece; ties go after the left half
+                    size_t b0 = (k == 0) ? mid : lower_bound(src + mid, src + bHi, src[a0], byPriority) - src;
+                    size_t b1 = (k + 1 == pieces) ? bHi : lower_bound(src + mid, src + bHi, src[a1], byPriority) - src;
+                    auto dst = to->begin() + (a0 + b0 - mid);
+                    workers.push_back(thread([=] {
+                        merge(make_move_iterator(src + a0), make_move_iterator(src + a1),
+                              make_move_iterator(src + b0), make_move_iterator(src + b1), dst, byPriority);
+                    }));
+                }
             }
+            for (thread& t : workers) t.join();
+            swap(from, to);
+        }
+        if (from != &items) {
+            items.swap(buffer);
         }
-        // go through left subtree
-        preOrderCopy(n->left);
-        // go through right subtree
-        preOrderCopy(n->right);
+    }
+    // private helper function for build(), makes a balanced subtree out of
+    // the runs of equal priorities runs[lo] .. runs[hi - 1]
+    NODE* buildTree(vector<pair<P, T>>& items, vector<int>& runs, int lo, int hi, NODE* parent, int budget) {
+        if (lo >= hi) {
+            return nullptr;
+        }
+        int mid = lo + (hi - lo) / 2;
+        int first = runs[mid];
+        int last = runs[mid + 1];
+        // first item of the run is the tree node, the rest are duplicates
+        NODE* newNode = new NODE;
+        newNode->priority = items[first].first;
+        newNode->value = items[first].second;
+        newNode->dup = (last - first > 1);
+        newNode->parent = parent;
+        newNode->link = nullptr;
+        newNode->left = nullptr;
+        newNode->right = nullptr;
+        newNode->count = last - first;
+        NODE* tail = newNode;
+        for (int i = first + 1; i < last; i++) {
+            tail = appendDup(tail, items[i].second);
+        }
+        if (budget > 1 && mid > lo) {
+            // build the left subtree on another thread
+            thread t([&] { newNode->left = buildTree(items, runs, lo, mid, newNode, budget / 2); });
+            newNode->right = buildTree(items, runs, mid + 1, hi, newNode, budget - budget / 2);
+            t.join();
+        } else {
+            newNode->left = buildTree(items, runs, lo, mid, newNode, budget);
+            newNode->right = buildTree(items, runs, mid + 1, hi, newNode, budget);
+        }
+        newNode->count += countOf(newNode->left) + countOf(newNode->right);
+        return newNode;
     }
     bool equal(NODE* cur, NODE* otherCur) const {
         if (cur == nullptr && otherCur == nullptr) {
@@ -127,12 +428,27 @@ public:
         root = nullptr;
         size = 0;
         curr = nullptr;
+        maxNode = nullptr;
+        threads = 1;
+    }
+    //
+    // range constructor:
+    //
+    // Creates a priority queue holding the (value, priority) pairs in
+    // [first, last), see build().
+    // O(nlogn), where n is the number of pairs
+    //
+    template<typename InputIt>
+    priorityqueue(InputIt first, InputIt last, int nthreads = 1) : priorityqueue() {
+        threads = (nthreads < 1) ? 1 : nthreads;
+        build(first, last);
     }
     //
     // operator=
     //
     // Clears "this" tree and then makes a copy of the "other" tree.
-    // Sets all member variables appropriately.
+    // Sets all member variables appropriately.  The copy has the same shape
+    // as "other" and is made with up to this tree's thread count.
     // O(n), where n is total number of nodes in custom BST
     //
     priorityqueue& operator=(const priorityqueue& other) {
@@ -146,12 +462,15 @@ public:
         this->root = nullptr;
         this->size = 0;
         this->curr = nullptr;
+        this->maxNode = nullptr;
         // return if tree is empty
         if (other.root == nullptr) {
             return *this;
         }
         // use preorder traversal to make a copy of the tree
-        this->preOrderCopy(other.root);
+        this->root = this->preOrderCopy(other.root, nullptr, this->threads);
+        this->size = other.size;
+        this->maxNode = this->rightmost(this->root);
         return *this;
     }
     //
@@ -161,14 +480,76 @@ public:
     // O(n), where n is total number of nodes in custom BST
     //
     void clear() {
-        // using post order traversal
-        NODE* n = root;
         // call post order function
-        postOrderDelete(root);
+        postOrderDelete(root, threads);
         // set size to 0, root and curr to nullptr
         size = 0;
         root = nullptr;
         curr = nullptr;
+        maxNode = nullptr;
+    }
+    //
+    // setThreads:
+    //
+    // Sets the max # of threads used by build(), operator=, clear() and
+    // toString().  The default of 1 keeps them single-threaded.  The top
+    // levels of the tree are split across threads, so the speedup depends
+    // on the tree being reasonably balanced (build() always makes one).
+    // O(1)
+    //
+    void setThreads(int nthreads) {
+        threads = (nthreads < 1) ? 1 : nthreads;
+    }
+    //
+    // build:
+    //
+    // Replaces the contents with the (value, priority) pairs in
+    // [first, last), e.g. from a vector<pair<T, P>>.  Pairs with equal
+    // priorities keep their order, as if they had been enqueued one by one.
+    // With random-access iterators the pairs are copied one chunk per
+    // thread.  They are then stable sorted and merged in parallel, and the
+    // BST is built balanced, one subtree per thread.
+    // O(nlogn), where n is the number of pairs
+    //
+    template<typename InputIt>
+    void build(InputIt first, InputIt last) {
+        clear();
+        vector<pair<P, T>> items;
+        if constexpr (is_base_of_v<random_access_iterator_tag, typename iterator_traits<InputIt>::iterator_category>) {
+            // copy one chunk per thread
+            items.resize(last - first);
+            parallelChunks(items.size(), [&](int, size_t lo, size_t hi) {
+                for (size_t i = lo; i < hi; i++) {
+                    items[i] = {first[i].second, first[i].first};
+                }
+            });
+        } else {
+            for (; first != last; ++first) {
+                items.push_back({first->second, first->first});
+            }
+        }
+        if (items.empty()) {
+            return;
+        }
+        parallelSort(items);
+        // start index of each run of equal priorities, found one chunk per
+        // thread, plus the end
+        vector<vector<int>> chunkRuns(threads);
+        int chunks = parallelChunks(items.size(), [&](int c, size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; i++) {
+                if (i == 0 || items[i].first != items[i - 1].first) {
+                    chunkRuns[c].push_back(i);
+                }
+            }
+        });
+        vector<int> runs;
+        for (int c = 0; c < chunks; c++) {
+            runs.insert(runs.end(), chunkRuns[c].begin(), chunkRuns[c].end());
+        }
+        runs.push_back(items.size());
+        root = buildTree(items, runs, 0, runs.size() - 1, nullptr, threads);
+        size = items.size();
+        maxNode = rightmost(root);
     }
     //
     // destructor:
@@ -187,7 +568,7 @@ public:
     // O(logn + m), where n is number of unique nodes in tree and m is number of
     // duplicate priorities
     //
-    void enqueue(T value, int priority) {
+    void enqueue(T value, P priority) {
         // check if tree is empty
         if (size == 0) {
             // set newNode to be root
@@ -199,7 +580,9 @@ public:
             newNode->link = nullptr;
             newNode->left = nullptr;
             newNode->right = nullptr;
+            newNode->count = 1;
             root = newNode;
+            maxNode = newNode;
             // increase size
             size++;
         } else {
@@ -208,6 +591,8 @@ public:
             NODE* cur = root;
             // traverse through tree by priority
             while (cur != nullptr) {
+                // the new element ends up in cur's subtree
+                cur->count++;
                 // if priority is same, there is a duplicate
                 if (priority == cur->priority) {
                     // make sure the first node in the list is marked as duplicate
@@ -229,6 +614,7 @@ public:
                     newNode->link = nullptr;
                     newNode->left = nullptr;
                     newNode->right = nullptr;
+                    newNode->count = 1;
                     // point previous node to newNode
                     p->link = newNode;
                     // update size
@@ -255,12 +641,17 @@ public:
             newNode->link = nullptr;
             newNode->left = nullptr;
             newNode->right = nullptr;
+            newNode->count = 1;
             // check whether newNode is the left or right subtree of prev
             if (priority < prev->priority) {
                 prev->left = newNode;
             } else {
                 prev->right = newNode;
             }
+            // keep track of the largest priority
+            if (priority > maxNode->priority) {
+                maxNode = newNode;
+            }
             // update Size
             size++;
         }
@@ -284,9 +675,11 @@ public:
             // tree is empty
             return {};
         }
-        // traverse to leftmost leaf in tree
+        // traverse to leftmost leaf in tree, every subtree on the way loses
+        // one element
         while (c != nullptr) {
             prev = c;
+            c->count--;
             c = c->left;
         }
         c = prev;
@@ -320,6 +713,7 @@ public:
                         root = nullptr;
                         size = 0;
                         curr = nullptr;
+                        maxNode = nullptr;
                     } else {
                         root = r;
                         r->parent = parent;
@@ -330,6 +724,11 @@ public:
                 parent = c->parent;
                 r = c->right;
                 next = c->link;
+                next->count = c->count;
+                // next inherits c's place in the tree, and maybe the max
+                if (maxNode == c) {
+                    maxNode = next;
+                }
                 // delete current node;
                 delete c;
                 size--;
@@ -375,6 +774,7 @@ public:
                     root = nullptr;
                     size = 0;
                     curr = nullptr;
+                    maxNode = nullptr;
                 } else {
                     root = r;
                     r->parent = parent;
@@ -440,13 +840,16 @@ public:
     //    }
     //    cout << priority << " value: " << value << endl;
     //
-    bool next(T& value, int &priority) {
+    bool next(T& value, P &priority) {
         NODE* c = curr; 
         NODE* child = nullptr;
         // special case when next() is called when the whole tree has already been traversed in order
         if (c == nullptr) {
-            // there is no more values/priorities to be given
-            priority = -999;
+            // there is no more values/priorities to be given; a P that
+            // cannot hold the -999 sentinel is left unchanged
+            if constexpr (is_convertible_v<int, P>) {
+                priority = -999;
+            }
             return false;
         }
         value = curr->value;
@@ -511,13 +914,47 @@ public:
     //
     string toString() {
         string result = "";
-        stringstream ss;
         // check if priorityqueue is empty
-        if (root == nullptr) return result; 
-        // call inOrder
-        inOrder(root, ss);
-        // convert stringstream to string and assign to result
-        result = ss.str();
+        if (root == nullptr) return result;
+        // one string per piece, the whole subtrees each written on their
+        // own thread, then joined with a single copy
+        vector<pair<NODE*, bool>> pieces;
+        splitWork(root, threads, pieces);
+        vector<string> parts(pieces.size());
+        auto write = [&](int i) {
+            stringstream ss;
+            if (pieces[i].second) {
+                inOrder(pieces[i].first, ss);
+            } else {
+                writeNode(pieces[i].first, ss);
+            }
+            parts[i] = move(ss).str();
+        };
+        // the last whole subtree is written on this thread
+        int last = (int)pieces.size() - 1;
+        while (last >= 0 && !pieces[last].second) {
+            last--;
+        }
+        vector<thread> workers;
+        for (int i = 0; i < (int)pieces.size(); i++) {
+            if (pieces[i].second && i != last) {
+                workers.push_back(thread(write, i));
+            } else {
+                write(i);
+            }
+        }
+        for (thread& t : workers) t.join();
+        if (parts.size() == 1) {
+            return move(parts[0]);
+        }
+        size_t length = 0;
+        for (const string& part : parts) {
+            length += part.size();
+        }
+        result.reserve(length);
+        for (const string& part : parts) {
+            result += part;
+        }
         return result;
     }
     //
@@ -546,6 +983,159 @@ public:
         return valueOut;
     }
     
+    //
+    // peekMax:
+    //
+    // returns the value of the element with the largest priority but does not
+    // remove it.  Among duplicates this is the first one enqueued.
+    // O(1)
+    //
+    T peekMax() {
+        if (maxNode == nullptr) {
+            // tree is empty
+            return {};
+        }
+        return maxNode->value;
+    }
+    //
+    // dequeueMax:
+    //
+    // returns the value of the element with the largest priority and removes
+    // it from the priority queue.  Among duplicates this is the first one
+    // enqueued.
+    // O(logn), where n is number of unique nodes in tree
+    //
+    T dequeueMax() {
+        NODE* c = maxNode;
+        NODE* parent = nullptr;
+        NODE* l = nullptr;
+        NODE* next = nullptr;
+        T valueOut;
+        if (c == nullptr) {
+            // tree is empty
+            return {};
+        }
+        valueOut = c->value;
+        // the max node is the rightmost node, so it never has a right subtree
+        parent = c->parent;
+        l = c->left;
+        // every subtree on the way from the root loses one element
+        for (NODE* a = parent; a != nullptr; a = a->parent) {
+            a->count--;
+        }
+        if (c->dup && c->link != nullptr) {
+            // the next duplicate takes c's place in the tree
+            next = c->link;
+            next->count = c->count - 1;
+            next->parent = parent;
+            next->left = l;
+            next->right = nullptr;
+            if (l != nullptr) {
+                l->parent = next;
+            }
+            if (parent == nullptr) {
+                root = next;
+            } else {
+                parent->right = next;
+            }
+            maxNode = next;
+        } else {
+            // rewire the left subtree into c's place
+            if (parent == nullptr) {
+                root = l;
+            } else {
+                parent->right = l;
+            }
+            if (l != nullptr) {
+                l->parent = parent;
+                // new max is the rightmost node of the left subtree
+                maxNode = l;
+                while (maxNode->right != nullptr) {
+                    maxNode = maxNode->right;
+                }
+            } else {
+                maxNode = parent;
+            }
+        }
+        if (curr == c) {
+            // the node being traversed no longer exists
+            curr = nullptr;
+        }
+        delete c;
+        size--;
+        return valueOut;
+    }
+    //
+    // countRange:
+    //
+    // Returns the # of elements with a priority in [lo, hi].  Uses the
+    // element count kept in every subtree, so nothing is visited beyond
+    // two root-to-leaf paths.
+    // O(logn), where n is number of unique nodes in tree
+    //
+    int countRange(const P& lo, const P& hi) const {
+        if (lo > hi) {
+            return 0;
+        }
+        return countBelow(hi, true) - countBelow(lo, false);
+    }
+    //
+    // extractRange:
+    //
+    // Removes every element with a priority in [lo, hi] and appends them to
+    // out as (value, priority) pairs, in the order dequeue would return
+    // them.  Returns the # of elements removed.
+    // O(logn + k), where k is the # of elements removed
+    //
+    int extractRange(const P& lo, const P& hi, vector<pair<T, P>>& out) {
+        if (lo > hi) {
+            return 0;
+        }
+        NODE* middle = cutRange(lo, hi);
+        int removed = countOf(middle);
+        extractInOrder(middle, out);
+        return removed;
+    }
+    //
+    // eraseRange:
+    //
+    // Removes every element with a priority in [lo, hi].  Returns the # of
+    // elements removed.
+    // O(logn + k), where k is the # of elements removed
+    //
+    int eraseRange(const P& lo, const P& hi) {
+        if (lo > hi) {
+            return 0;
+        }
+        NODE* middle = cutRange(lo, hi);
+        int removed = countOf(middle);
+        postOrderDelete(middle, threads);
+        return removed;
+    }
+    //
+    // split:
+    //
+    // Moves every element with a priority of p or more into other, which
+    // is cleared first.  Duplicates stay in their original order.
+    // O(logn) plus clearing other
+    //
+    void split(const P& p, priorityqueue& other) {
+        if (this == &other) {
+            return;
+        }
+        other.clear();
+        NODE* less = nullptr;
+        NODE* rest = nullptr;
+        splitTree(root, p, false, less, rest);
+        root = less;
+        size = countOf(less);
+        maxNode = rightmost(less);
+        curr = nullptr;
+        other.root = rest;
+        other.size = countOf(rest);
+        other.maxNode = other.rightmost(rest);
+    }
+    
     //
     // ==operator
     //
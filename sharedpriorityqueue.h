@@ -0,0 +1,615 @@
+// sharedpriorityqueue.h
+//
+// A priority queue that lives in a named POSIX shared memory segment, so
+// producers and consumers in different processes can use the same queue
+// without copying elements through a socket.
+//
+// The segment holds a header followed by a fixed array of nodes.  Since
+// every process maps the segment at a different address, links are node
+// indices into that array rather than pointers.  A process-shared, robust
+// mutex guards the queue.  Blocked consumers sleep on a futex on a wake
+// counter in the header, which every enqueue bumps.
+//
+// Crash safety: every node has a "used" flag that is the commit point of
+// each operation.  enqueue sets it before linking the node into the BST
+// and dequeue clears it before unlinking.  If a process dies while holding
+// the mutex, the next process to lock it gets EOWNERDEAD.  That process
+// then rebuilds the BST and the free list from the used flags, ordering
+// duplicates by their enqueue sequence number.  An element being dequeued
+// by the dead process is lost, but no element is ever handed out twice.
+// A futex keeps no state in the segment besides the counter, so a process
+// killed while blocked in waitDequeue() leaves nothing to repair either.
+// A consumer killed right after being woken takes that wakeup with it,
+// so blocked consumers also wake every WAIT_SLICE_MS to re-check the
+// queue.  Either way, other processes can keep using the queue or re-open
+// it by name.
+//
+// Setting up a new segment happens under an flock() on it, which the
+// kernel drops if the creator dies.  open() waits for that lock for as
+// long as its holder is alive, however big the segment is.  A process
+// that opens a segment its creator never finished sets it up again
+// itself.
+//
+// T must be trivially copyable, as it is copied into shared memory
+// byte for byte.  The segment is not removed when the last process closes
+// it; call sharedpriorityqueue::remove(name) for that.
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <pthread.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace std;
+
+template<typename T>
+class sharedpriorityqueue {
+    static_assert(is_trivially_copyable<T>::value, "sharedpriorityqueue needs a trivially copyable T");
+ private:
+    static const uint32_t NIL = 0xFFFFFFFF;  // "null" index
+    static const uint32_t MAGIC = 0x50515348;  // marks a fully set up segment
+    static constexpr int WAIT_SLICE_MS = 100;  // max sleep before re-checking the queue
+    struct NODE {
+        int priority;  // used to build BST
+        uint32_t link;  // next duplicate, or next free node
+        uint32_t left;  // index of left child
+        uint32_t right;  // index of right child
+        uint64_t seq;  // enqueue order, used to rebuild after a crash
+        uint32_t used;  // 1 while the node holds an element
+        T value;  // stored data for the p-queue
+    };
+    struct HEADER {
+        uint32_t magic;  // MAGIC once the creator has finished setting up
+        uint32_t capacity;  // # of nodes in the segment
+        uint32_t nodeSize;  // sizeof(NODE), to catch a mismatched T
+        uint32_t root;  // index of root node of the BST
+        uint32_t freeList;  // index of first free node
+        int size;  // # of elements in the pqueue
+        uint64_t nextSeq;  // seq for the next enqueue
+        uint32_t wakeups;  // bumped once per enqueue, the futex consumers sleep on
+        pthread_mutex_t lock;  // guards everything in the segment
+    };
+    HEADER* header;  // start of the mapped segment, nullptr if not open
+    NODE* nodes;  // node array, right after the header
+    size_t length;  // # of bytes mapped
+
+    static size_t nodesOffset() {
+        return (sizeof(HEADER) + alignof(NODE) - 1) / alignof(NODE) * alignof(NODE);
+    }
+    static size_t segmentSize(uint32_t capacity) {
+        return nodesOffset() + (size_t)capacity * sizeof(NODE);
+    }
+    // private helper function that sets up a newly created segment
+    void initialize(uint32_t capacity) {
+        header->capacity = capacity;
+        header->nodeSize = sizeof(NODE);
+        header->root = NIL;
+        header->size = 0;
+        header->nextSeq = 0;
+        header->wakeups = 0;
+        header->freeList = NIL;
+        for (uint32_t i = capacity; i > 0; i--) {
+            nodes[i - 1].used = 0;
+            nodes[i - 1].link = header->freeList;
+            header->freeList = i - 1;
+        }
+        pthread_mutexattr_t mattr;
+        pthread_mutexattr_init(&mattr);
+        pthread_mutexattr_setpshared(&mattr, PTHREAD_PROCESS_SHARED);
+        pthread_mutexattr_setrobust(&mattr, PTHREAD_MUTEX_ROBUST);
+        pthread_mutex_init(&header->lock, &mattr);
+        pthread_mutexattr_destroy(&mattr);
+        // publish last, an opener that finds no MAGIC sets up again
+        __atomic_store_n(&header->magic, MAGIC, __ATOMIC_RELEASE);
+    }
+    // private helper function for rebuild(), makes a balanced subtree out
+    // of the runs of equal priorities runs[lo] .. runs[hi - 1]
+    uint32_t buildTree(vector<uint32_t>& live, vector<uint32_t>& runs, uint32_t lo, uint32_t hi) {
+        if (lo >= hi) {
+            return NIL;
+        }
+        uint32_t mid = lo + (hi - lo) / 2;
+        // chain the run together, the first node is the tree node
+        for (uint32_t i = runs[mid]; i < runs[mid + 1]; i++) {
+            nodes[live[i]].left = NIL;
+            nodes[live[i]].right = NIL;
+            nodes[live[i]].link = (i + 1 < runs[mid + 1]) ? live[i + 1] : NIL;
+        }
+        uint32_t n = live[runs[mid]];
+        nodes[n].left = buildTree(live, runs, lo, mid);
+        nodes[n].right = buildTree(live, runs, mid + 1, hi);
+        return n;
+    }
+    // private helper function that repairs the segment after a process
+    // died holding the lock: the used flags are the only thing trusted
+    void rebuild() {
+        vector<uint32_t> live;
+        header->freeList = NIL;
+        uint64_t maxSeq = 0;
+        for (uint32_t i = header->capacity; i > 0; i--) {
+            if (__atomic_load_n(&nodes[i - 1].used, __ATOMIC_ACQUIRE)) {
+                live.push_back(i - 1);
+                maxSeq = max(maxSeq, nodes[i - 1].seq + 1);
+            } else {
+                nodes[i - 1].link = header->freeList;
+                header->freeList = i - 1;
+            }
+        }
+        sort(live.begin(), live.end(), [this](uint32_t a, uint32_t b) {
+            if (nodes[a].priority != nodes[b].priority) {
+                return nodes[a].priority < nodes[b].priority;
+            }
+            return nodes[a].seq < nodes[b].seq;
+        });
+        vector<uint32_t> runs;
+        for (uint32_t i = 0; i < live.size(); i++) {
+            if (i == 0 || nodes[live[i]].priority != nodes[live[i - 1]].priority) {
+                runs.push_back(i);
+            }
+        }
+        runs.push_back(live.size());
+        header->root = buildTree(live, runs, 0, runs.size() - 1);
+        header->size = live.size();
+        header->nextSeq = max(header->nextSeq, maxSeq);
+    }
+    // private helper function that takes the lock, repairing the segment
+    // if its last owner died
+    void lock() {
+        if (pthread_mutex_lock(&header->lock) == EOWNERDEAD) {
+            rebuild();
+            pthread_mutex_consistent(&header->lock);
+        }
+    }
+    void unlock() {
+        pthread_mutex_unlock(&header->lock);
+    }
+    // private helper function, the CLOCK_MONOTONIC time ns from now
+    static timespec after(long long ns) {
+        timespec t;
+        clock_gettime(CLOCK_MONOTONIC, &t);
+        t.tv_sec += ns / 1000000000 + (t.tv_nsec + ns % 1000000000) / 1000000000;
+        t.tv_nsec = (t.tv_nsec + ns % 1000000000) % 1000000000;
+        return t;
+    }
+    // private helper function that waits for an enqueue until deadline (or
+    // forever if deadline is nullptr), returns false on timeout.  The lock
+    // must be held; it is dropped while sleeping and held again on return.
+    // A wakeup can be lost with a consumer killed right after getting it,
+    // so this never sleeps longer than WAIT_SLICE_MS, and callers re-check
+    // the queue.
+    bool wait(const timespec* deadline) {
+        // read under the lock, so an enqueue after this changes the counter
+        // and FUTEX_WAIT returns at once
+        uint32_t seen = __atomic_load_n(&header->wakeups, __ATOMIC_ACQUIRE);
+        long long ns = (long long)WAIT_SLICE_MS * 1000000;
+        bool last = false;
+        if (deadline != nullptr) {
+            timespec now = after(0);
+            long long left = (deadline->tv_sec - now.tv_sec) * 1000000000LL + (deadline->tv_nsec - now.tv_nsec);
+            if (left <= ns) {
+                ns = max(left, 0LL);
+                last = true;
+            }
+        }
+        unlock();
+        timespec slice;
+        slice.tv_sec = ns / 1000000000;
+        slice.tv_nsec = ns % 1000000000;
+        // not FUTEX_PRIVATE_FLAG, the counter is shared between processes
+        syscall(SYS_futex, &header->wakeups, FUTEX_WAIT, seen, &slice, nullptr, 0);
+        lock();
+        if (!last || __atomic_load_n(&header->wakeups, __ATOMIC_ACQUIRE) != seen) {
+            return true;
+        }
+        // woken early by a signal, keep waiting if time is left
+        timespec now = after(0);
+        return now.tv_sec < deadline->tv_sec || (now.tv_sec == deadline->tv_sec && now.tv_nsec < deadline->tv_nsec);
+    }
+    // private helper function that removes the smallest element, the lock
+    // must be held and the queue must not be empty
+    T removeMin() {
+        uint32_t parent = NIL;
+        uint32_t c = header->root;
+        while (nodes[c].left != NIL) {
+            parent = c;
+            c = nodes[c].left;
+        }
+        T valueOut = nodes[c].value;
+        // commit point
+        __atomic_store_n(&nodes[c].used, 0, __ATOMIC_RELEASE);
+        uint32_t next = nodes[c].link;
+        uint32_t replacement = nodes[c].right;
+        if (next != NIL) {
+            // the next duplicate takes c's place in the tree
+            nodes[next].right = nodes[c].right;
+            replacement = next;
+        }
+        if (parent == NIL) {
+            header->root = replacement;
+        } else {
+            nodes[parent].left = replacement;
+        }
+        nodes[c].link = header->freeList;
+        header->freeList = c;
+        header->size--;
+        return valueOut;
+    }
+    // private helper function for open(), maps the segment behind fd and
+    // sets it up unless an earlier process already has.  The caller holds
+    // the flock on fd.
+    bool attach(int fd, int capacity) {
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            return false;
+        }
+        size_t bytes = st.st_size;
+        if (bytes >= sizeof(HEADER)) {
+            void* base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (base == MAP_FAILED) {
+                return false;
+            }
+            header = (HEADER*)base;
+            nodes = (NODE*)((char*)base + nodesOffset());
+            length = bytes;
+            if (__atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) == MAGIC) {
+                if (header->nodeSize != sizeof(NODE) || segmentSize(header->capacity) > length) {
+                    close();
+                    return false;
+                }
+                return true;
+            }
+            // the creator died part way through
+            close();
+        }
+        if (capacity <= 0) {
+            return false;
+        }
+        bytes = segmentSize(capacity);
+        if (ftruncate(fd, bytes) != 0) {
+            return false;
+        }
+        void* base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (base == MAP_FAILED) {
+            return false;
+        }
+        header = (HEADER*)base;
+        nodes = (NODE*)((char*)base + nodesOffset());
+        length = bytes;
+        initialize(capacity);
+        return true;
+    }
+    // private helper function for toString() method
+    void inOrder(uint32_t n, stringstream& ss) {
+        if (n == NIL) return;
+        inOrder(nodes[n].left, ss);
+        for (uint32_t c = n; c != NIL; c = nodes[c].link) {
+            ss << nodes[c].priority << " value: " << nodes[c].value << endl;
+        }
+        inOrder(nodes[n].right, ss);
+    }
+ public:
+    //
+    // default constructor:
+    //
+    // Creates a handle that is not attached to any segment yet, see open().
+    // O(1)
+    //
+    sharedpriorityqueue() {
+        header = nullptr;
+        nodes = nullptr;
+        length = 0;
+    }
+    //
+    // destructor:
+    //
+    // Detaches from the segment.  The queue itself stays in shared memory.
+    // O(1)
+    //
+    ~sharedpriorityqueue() {
+        close();
+    }
+    // a handle owns its mapping, copies would unmap it twice
+    sharedpriorityqueue(const sharedpriorityqueue&) = delete;
+    sharedpriorityqueue& operator=(const sharedpriorityqueue&) = delete;
+    //
+    // open:
+    //
+    // Attaches to the segment called name (e.g. "/dispatch"), creating it
+    // with room for capacity elements if it does not exist yet, or if the
+    // process that created it died before setting it up.  When the segment
+    // already exists, capacity is ignored.  Returns false if the segment
+    // cannot be created or mapped, or was made for a different T.  While
+    // another process is setting the segment up, this blocks until it
+    // finishes or dies.
+    // O(capacity) when creating, O(1) otherwise
+    //
+    bool open(const string& name, int capacity) {
+        close();
+        bool created = true;
+        int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (fd < 0 && errno == EEXIST) {
+            created = false;
+            fd = shm_open(name.c_str(), O_RDWR, 0600);
+        }
+        if (fd < 0) {
+            return false;
+        }
+        // only one process at a time sets up or checks the segment
+        while (flock(fd, LOCK_EX) != 0) {
+            if (errno != EINTR) {
+                ::close(fd);
+                return false;
+            }
+        }
+        bool result = attach(fd, capacity);
+        flock(fd, LOCK_UN);
+        ::close(fd);
+        if (!result && created) {
+            shm_unlink(name.c_str());
+        }
+        return result;
+    }
+    //
+    // close:
+    //
+    // Detaches from the segment, if attached.
+    // O(1)
+    //
+    void close() {
+        if (header != nullptr) {
+            munmap(header, length);
+        }
+        header = nullptr;
+        nodes = nullptr;
+        length = 0;
+    }
+    //
+    // remove:
+    //
+    // Removes the segment called name from the system.  Processes still
+    // attached keep working on it until they close.
+    // O(1)
+    //
+    static void remove(const string& name) {
+        shm_unlink(name.c_str());
+    }
+    //
+    // enqueue:
+    //
+    // Inserts the value based on priority and wakes one waiting consumer.
+    // Returns false if the queue is full or not open.
+    // O(logn + m), where n is number of unique nodes in tree and m is number of
+    // duplicate priorities
+    //
+    bool enqueue(T value, int priority) {
+        if (header == nullptr) {
+            return false;
+        }
+        lock();
+        uint32_t n = header->freeList;
+        if (n == NIL) {
+            unlock();
+            return false;
+        }
+        header->freeList = nodes[n].link;
+        nodes[n].priority = priority;
+        nodes[n].link = NIL;
+        nodes[n].left = NIL;
+        nodes[n].right = NIL;
+        nodes[n].seq = header->nextSeq++;
+        nodes[n].value = value;
+        // commit point, the fields above are visible before the flag
+        __atomic_store_n(&nodes[n].used, 1, __ATOMIC_RELEASE);
+        header->size++;
+        if (header->root == NIL) {
+            header->root = n;
+        } else {
+            uint32_t prev = NIL;
+            uint32_t cur = header->root;
+            while (cur != NIL) {
+                if (priority == nodes[cur].priority) {
+                    // append to the end of the list of duplicates
+                    while (nodes[cur].link != NIL) {
+                        cur = nodes[cur].link;
+                    }
+                    nodes[cur].link = n;
+                    break;
+                }
+                prev = cur;
+                cur = (priority < nodes[cur].priority) ? nodes[cur].left : nodes[cur].right;
+            }
+            if (cur == NIL) {
+                if (priority < nodes[prev].priority) {
+                    nodes[prev].left = n;
+                } else {
+                    nodes[prev].right = n;
+                }
+            }
+        }
+        __atomic_add_fetch(&header->wakeups, 1, __ATOMIC_RELEASE);
+        unlock();
+        // wake one blocked consumer, in any process
+        syscall(SYS_futex, &header->wakeups, FUTEX_WAKE, 1, nullptr, nullptr, 0);
+        return true;
+    }
+    //
+    // dequeue:
+    //
+    // returns the value of the next element in the priority queue and removes
+    // the element from the priority queue.  Returns {} if empty.
+    // O(logn), where n is number of unique nodes in tree
+    //
+    T dequeue() {
+        T valueOut{};
+        tryDequeue(valueOut);
+        return valueOut;
+    }
+    //
+    // tryDequeue:
+    //
+    // Removes the next element into value without blocking.  Returns false
+    // if the queue is empty or not open.
+    // O(logn)
+    //
+    bool tryDequeue(T& value) {
+        if (header == nullptr) {
+            return false;
+        }
+        lock();
+        bool found = (header->size > 0);
+        if (found) {
+            value = removeMin();
+        }
+        unlock();
+        return found;
+    }
+    //
+    // waitDequeue:
+    //
+    // Blocks until an element is available, possibly enqueued by another
+    // process, and removes it into value.  Returns false if not open.
+    // O(logn) once woken
+    //
+    bool waitDequeue(T& value) {
+        if (header == nullptr) {
+            return false;
+        }
+        lock();
+        while (header->size == 0) {
+            // re-checks at least every WAIT_SLICE_MS, see wait()
+            wait(nullptr);
+        }
+        value = removeMin();
+        unlock();
+        return true;
+    }
+    //
+    // tryDequeueFor:
+    //
+    // Like waitDequeue(), but gives up after timeout.  Returns false on
+    // timeout.
+    // O(logn) once woken
+    //
+    template<typename Rep, typename Period>
+    bool tryDequeueFor(T& value, const chrono::duration<Rep, Period>& timeout) {
+        if (header == nullptr) {
+            return false;
+        }
+        timespec deadline = after(chrono::duration_cast<chrono::nanoseconds>(timeout).count());
+        lock();
+        while (header->size == 0) {
+            if (!wait(&deadline)) {
+                break;
+            }
+        }
+        bool found = (header->size > 0);
+        if (found) {
+            value = removeMin();
+        }
+        unlock();
+        return found;
+    }
+    //
+    // peek:
+    //
+    // returns the value of the next element in the priority queue but does not
+    // remove the item from the priority queue.  Returns {} if empty.
+    // O(logn)
+    //
+    T peek() {
+        T valueOut{};
+        if (header == nullptr) {
+            return valueOut;
+        }
+        lock();
+        uint32_t c = header->root;
+        if (c != NIL) {
+            while (nodes[c].left != NIL) {
+                c = nodes[c].left;
+            }
+            valueOut = nodes[c].value;
+        }
+        unlock();
+        return valueOut;
+    }
+    //
+    // Size:
+    //
+    // Returns the # of elements in the priority queue, 0 if empty.
+    // O(1)
+    //
+    int Size() {
+        if (header == nullptr) {
+            return 0;
+        }
+        lock();
+        int result = header->size;
+        unlock();
+        return result;
+    }
+    //
+    // Capacity:
+    //
+    // Returns the max # of elements the segment can hold.
+    // O(1)
+    //
+    int Capacity() {
+        return (header == nullptr) ? 0 : header->capacity;
+    }
+    //
+    // toString:
+    //
+    // Returns a string of the entire priority queue, in order, in the same
+    // format as priorityqueue::toString.
+    //
+    string toString() {
+        stringstream ss;
+        if (header == nullptr) {
+            return "";
+        }
+        lock();
+        inOrder(header->root, ss);
+        unlock();
+        return ss.str();
+    }
+    //
+    // clear:
+    //
+    // Removes every element, for every attached process.
+    // O(capacity)
+    //
+    void clear() {
+        if (header == nullptr) {
+            return;
+        }
+        lock();
+        for (uint32_t i = 0; i < header->capacity; i++) {
+            __atomic_store_n(&nodes[i].used, 0, __ATOMIC_RELEASE);
+        }
+        rebuild();
+        unlock();
+    }
+    //
+    // getLock
+    //
+    // Used for testing crash recovery.
+    // return the segment's process-shared mutex, nullptr if not open.
+    //
+    void* getLock() {
+        return (header == nullptr) ? nullptr : &header->lock;
+    }
+};
@@ -0,0 +1,116 @@
+// staticpriorityqueue.h
+//
+// A fixed-capacity priority queue that never allocates.
+//
+// staticpriorityqueue<T, N> keeps its N nodes in an array inside the
+// object itself, so it lives wherever the object does (stack, member,
+// static storage).  The BST is the index-linked one of
+// compactpriorityqueue, see indexedpriorityqueue.h.  There is no
+// traversal stack either: next() finds the in-order successor by walking
+// down from the root.
+//
+// Everything except toString() is constexpr, so for a literal T a queue
+// can be filled and drained at compile time.  tryEnqueue() returns false
+// when all N nodes are in use; enqueue() has the same signature as
+// priorityqueue's and drops the value in that case.
+#pragma once
+
+#include <cstdint>
+
+#include "indexedpriorityqueue.h"
+
+using namespace std;
+
+// storage back end for staticpriorityqueue, an inline array of N nodes
+template<typename T, int N>
+class arraynodes {
+ private:
+    indexednode<T> nodes[N];  // every node, used or not
+    uint32_t used = 0;  // # of nodes handed out so far
+ public:
+    constexpr indexednode<T>& operator[](uint32_t n) {
+        return nodes[n];
+    }
+    constexpr const indexednode<T>& operator[](uint32_t n) const {
+        return nodes[n];
+    }
+    constexpr uint32_t grow() {
+        return (used < N) ? used++ : INDEXNIL;
+    }
+    constexpr void reset() {
+        for (uint32_t i = 0; i < used; i++) {
+            nodes[i] = indexednode<T>();
+        }
+        used = 0;
+    }
+};
+
+template<typename T, int N>
+class staticpriorityqueue : public indexedpriorityqueue<T, arraynodes<T, N>> {
+    static_assert(N > 0, "staticpriorityqueue needs room for at least one element");
+ private:
+    typedef indexedpriorityqueue<T, arraynodes<T, N>> base;
+    using base::NIL;
+    using base::nodes;
+    using base::root;
+    using base::curr;
+ public:
+    //
+    // Capacity:
+    //
+    // Returns N, the max # of elements.
+    // O(1)
+    //
+    constexpr int Capacity() const {
+        return N;
+    }
+    //
+    // begin
+    //
+    // Resets internal state for an inorder traversal, see
+    // priorityqueue::begin.
+    // O(logn), where n is number of unique nodes in tree
+    //
+    constexpr void begin() {
+        curr = root;
+        if (curr != NIL) {
+            while (nodes[curr].left != NIL) {
+                curr = nodes[curr].left;
+            }
+        }
+    }
+    //
+    // next
+    //
+    // Returns the next inorder value/priority via the reference parameters
+    // and advances the internal state, see priorityqueue::next.
+    // O(logn + m), where n is number of unique nodes in tree
+    //
+    constexpr bool next(T& value, int &priority) {
+        if (curr == NIL) {
+            // there is no more values/priorities to be given
+            priority = -999;
+            return false;
+        }
+        value = nodes[curr].value;
+        priority = nodes[curr].priority;
+        if (nodes[curr].link != NIL) {
+            // next duplicate
+            curr = nodes[curr].link;
+            return true;
+        }
+        // find the smallest priority above this one, starting at the root
+        uint32_t successor = NIL;
+        uint32_t c = root;
+        while (c != NIL) {
+            if (nodes[c].priority > priority) {
+                successor = c;
+                c = nodes[c].left;
+            } else {
+                c = nodes[c].right;
+            }
+        }
+        curr = successor;
+        return curr != NIL;
+    }
+};
@@ -1,6 +1,22 @@
 #include <gtest/gtest.h>
 #include <string>
+#include <thread>
+#include <deque>
+#include <coroutine>
+#include <list>
+#include <map>
+#include <optional>
+#include <vector>
+#include <csignal>
+#include <sys/file.h>
+#include <sys/wait.h>
 #include "priorityqueue.h"
+#include "blockingpriorityqueue.h"
+#include "asyncpriorityqueue.h"
+#include "compactpriorityqueue.h"
+#include "persistentpriorityqueue.h"
+#include "sharedpriorityqueue.h"
+#include "staticpriorityqueue.h"
 
 TEST(priorityqueue, one) {
     // multiple instances of priorityqueue with different data typese
@@ -299,4 +315,1135 @@ TEST(priorityqueue, equalityOperator) {
     ASSERT_EQ(pqInt2 == pqInt3, true);
     ASSERT_EQ(pqInt == pqInt4, false);
     ASSERT_EQ(pqInt == pqInt5, false);
-}
\ No newline at end of file
+}
+TEST(blockingpriorityqueue, waitDequeue) {
+    blockingpriorityqueue<int> bpq;
+    int value = 0;
+    // consumer blocks until the producer enqueues
+    thread consumer([&] {
+        ASSERT_EQ(bpq.waitDequeue(value), true);
+    });
+    this_thread::sleep_for(chrono::milliseconds(20));
+    bpq.enqueue(42, 1);
+    consumer.join();
+    ASSERT_EQ(value, 42);
+    ASSERT_EQ(bpq.Size(), 0);
+    // elements still come out by priority
+    bpq.enqueue(1, 5);
+    bpq.enqueue(2, 3);
+    bpq.enqueue(3, 5);
+    ASSERT_EQ(bpq.waitDequeue(value), true);
+    ASSERT_EQ(value, 2);
+    ASSERT_EQ(bpq.tryDequeue(value), true);
+    ASSERT_EQ(value, 1);
+    ASSERT_EQ(bpq.tryDequeue(value), true);
+    ASSERT_EQ(value, 3);
+    ASSERT_EQ(bpq.tryDequeue(value), false);
+}
+
+TEST(blockingpriorityqueue, tryDequeueFor) {
+    blockingpriorityqueue<int> bpq;
+    int value = 0;
+    auto start = chrono::steady_clock::now();
+    ASSERT_EQ(bpq.tryDequeueFor(value, chrono::milliseconds(30)), false);
+    ASSERT_GE(chrono::steady_clock::now() - start, chrono::milliseconds(30));
+    bpq.enqueue(7, 2);
+    ASSERT_EQ(bpq.tryDequeueFor(value, chrono::milliseconds(30)), true);
+    ASSERT_EQ(value, 7);
+}
+
+TEST(blockingpriorityqueue, close) {
+    blockingpriorityqueue<int> bpq;
+    int value = 0;
+    bool results[3];
+    thread consumers[3];
+    for (int i = 0; i < 3; i++) {
+        consumers[i] = thread([&, i] { results[i] = bpq.waitDequeue(value); });
+    }
+    this_thread::sleep_for(chrono::milliseconds(20));
+    bpq.close();
+    for (int i = 0; i < 3; i++) {
+        consumers[i].join();
+        ASSERT_EQ(results[i], false);
+    }
+    ASSERT_EQ(bpq.isClosed(), true);
+    ASSERT_EQ(bpq.enqueue(1, 1), false);
+    ASSERT_EQ(bpq.Size(), 0);
+}
+
+TEST(delayqueue, deadlines) {
+    delayqueue<int> dq;
+    int value = 0;
+    auto start = delayqueue<int>::clock::now();
+    dq.enqueue(3, start + chrono::milliseconds(60));
+    dq.enqueue(1, start + chrono::milliseconds(20));
+    dq.enqueue(2, start + chrono::milliseconds(40));
+    EXPECT_EQ(dq.Size(), 3);
+    // nothing is due yet
+    ASSERT_EQ(dq.tryDequeue(value), false);
+    ASSERT_EQ(dq.waitDequeue(value), true);
+    ASSERT_EQ(value, 1);
+    ASSERT_GE(delayqueue<int>::clock::now() - start, chrono::milliseconds(20));
+    ASSERT_EQ(dq.waitDequeue(value), true);
+    ASSERT_EQ(value, 2);
+    ASSERT_GE(delayqueue<int>::clock::now() - start, chrono::milliseconds(40));
+    // times out before the last deadline
+    ASSERT_EQ(dq.tryDequeueFor(value, chrono::milliseconds(1)), false);
+    ASSERT_EQ(dq.waitDequeue(value), true);
+    ASSERT_EQ(value, 3);
+    ASSERT_GE(delayqueue<int>::clock::now() - start, chrono::milliseconds(60));
+    ASSERT_EQ(dq.Size(), 0);
+}
+
+TEST(delayqueue, earlierItemWakesLeader) {
+    delayqueue<int> dq;
+    int value = 0;
+    auto start = delayqueue<int>::clock::now();
+    dq.enqueueAfter(2, chrono::seconds(10));
+    thread consumer([&] {
+        ASSERT_EQ(dq.waitDequeue(value), true);
+    });
+    this_thread::sleep_for(chrono::milliseconds(20));
+    // the sleeping consumer must re-arm on the new earliest deadline
+    dq.enqueueAfter(1, chrono::milliseconds(10));
+    consumer.join();
+    ASSERT_EQ(value, 1);
+    ASSERT_LT(delayqueue<int>::clock::now() - start, chrono::seconds(5));
+    dq.close();
+    ASSERT_EQ(dq.waitDequeue(value), false);
+    ASSERT_EQ(dq.Size(), 1);
+}
+
+TEST(delayqueue, fullResolutionOrder) {
+    delayqueue<int> dq;
+    int value = 0;
+    auto past = delayqueue<int>::clock::now() - chrono::milliseconds(10);
+    // deadlines within one millisecond, enqueued in reverse
+    dq.enqueue(3, past + chrono::microseconds(300));
+    dq.enqueue(2, past + chrono::microseconds(200));
+    dq.enqueue(1, past + chrono::microseconds(100));
+    // deadlines a month or more away keep their order too
+    dq.enqueueAfter(5, chrono::hours(24 * 60));
+    dq.enqueueAfter(4, chrono::hours(24 * 30));
+    for (int i = 1; i <= 3; i++) {
+        ASSERT_EQ(dq.tryDequeue(value), true);
+        ASSERT_EQ(value, i);
+    }
+    ASSERT_EQ(dq.tryDequeue(value), false);
+
+    priorityqueue<int, delayqueue<int>::time_point> pq;
+    auto now = delayqueue<int>::clock::now();
+    pq.enqueue(5, now + chrono::hours(24 * 60));
+    pq.enqueue(4, now + chrono::hours(24 * 30));
+    pq.enqueue(6, now + chrono::hours(24 * 60));
+    // walk it with begin/next
+    auto deadline = now;
+    pq.begin();
+    ASSERT_EQ(pq.next(value, deadline), true);
+    ASSERT_EQ(value, 4);
+    ASSERT_EQ(deadline, now + chrono::hours(24 * 30));
+    ASSERT_EQ(pq.next(value, deadline), true);
+    ASSERT_EQ(value, 5);
+    ASSERT_EQ(pq.next(value, deadline), false);
+    ASSERT_EQ(value, 6);
+    ASSERT_EQ(deadline, now + chrono::hours(24 * 60));
+    // past the end the deadline is left alone
+    ASSERT_EQ(pq.next(value, deadline), false);
+    ASSERT_EQ(deadline, now + chrono::hours(24 * 60));
+    ASSERT_EQ(pq.dequeue(), 4);
+    ASSERT_EQ(pq.dequeue(), 5);
+}
+
+// fire-and-forget coroutine type used by the asyncpriorityqueue tests
+struct detachedtask {
+    struct promise_type {
+        detachedtask get_return_object() { return {}; }
+        suspend_never initial_suspend() { return {}; }
+        suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { terminate(); }
+    };
+};
+
+static detachedtask asyncConsumer(asyncpriorityqueue<int>& apq, deque<int>& out, int count) {
+    for (int i = 0; i < count; i++) {
+        optional<int> value = co_await apq.async_dequeue();
+        if (!value) {
+            // closed
+            co_return;
+        }
+        out.push_back(*value);
+    }
+}
+
+TEST(asyncpriorityqueue, fastPath) {
+    asyncpriorityqueue<int> apq;
+    deque<int> out;
+    apq.enqueue(3, 30);
+    apq.enqueue(1, 10);
+    apq.enqueue(2, 20);
+    // all elements are available, so the consumer never suspends
+    asyncConsumer(apq, out, 3);
+    ASSERT_EQ(out.size(), 3);
+    ASSERT_EQ(out[0], 1);
+    ASSERT_EQ(out[1], 2);
+    ASSERT_EQ(out[2], 3);
+    ASSERT_EQ(apq.Size(), 0);
+    ASSERT_EQ(apq.Waiting(), 0);
+}
+
+TEST(asyncpriorityqueue, resumeInline) {
+    asyncpriorityqueue<int> apq;
+    deque<int> first, second;
+    asyncConsumer(apq, first, 2);
+    asyncConsumer(apq, second, 1);
+    ASSERT_EQ(apq.Waiting(), 2);
+    // waiters are served in FIFO order, each resumed inside enqueue
+    apq.enqueue(7, 5);
+    ASSERT_EQ(first.size(), 1);
+    ASSERT_EQ(first[0], 7);
+    ASSERT_EQ(apq.Waiting(), 2);
+    apq.enqueue(8, 1);
+    ASSERT_EQ(second.size(), 1);
+    ASSERT_EQ(second[0], 8);
+    apq.enqueue(9, 1);
+    ASSERT_EQ(first.size(), 2);
+    ASSERT_EQ(first[1], 9);
+    ASSERT_EQ(apq.Waiting(), 0);
+    ASSERT_EQ(apq.Size(), 0);
+}
+
+TEST(asyncpriorityqueue, eventLoop) {
+    // single-threaded event loop: woken consumers are posted, not resumed
+    deque<coroutine_handle<>> ready;
+    asyncpriorityqueue<int> apq([&](coroutine_handle<> h) { ready.push_back(h); });
+    deque<int> out;
+    asyncConsumer(apq, out, 4);
+    ASSERT_EQ(apq.Waiting(), 1);
+    apq.enqueue(10, 4);
+    ASSERT_EQ(out.size(), 0);
+    ASSERT_EQ(ready.size(), 1);
+    // items enqueued before the loop runs are ordered by priority
+    apq.enqueue(30, 3);
+    apq.enqueue(20, 2);
+    apq.enqueue(40, 4);
+    ASSERT_EQ(apq.Size(), 3);
+    while (!ready.empty()) {
+        coroutine_handle<> h = ready.front();
+        ready.pop_front();
+        h.resume();
+    }
+    ASSERT_EQ(out.size(), 4);
+    ASSERT_EQ(out[0], 10);
+    ASSERT_EQ(out[1], 20);
+    ASSERT_EQ(out[2], 30);
+    ASSERT_EQ(out[3], 40);
+    ASSERT_EQ(apq.Waiting(), 0);
+}
+
+TEST(asyncpriorityqueue, close) {
+    deque<int> first, second, third;
+    {
+        asyncpriorityqueue<int> apq;
+        asyncConsumer(apq, first, 3);
+        asyncConsumer(apq, second, 3);
+        ASSERT_EQ(apq.Waiting(), 2);
+        apq.enqueue(1, 1);
+        ASSERT_EQ(first.size(), 1);
+        // close wakes both waiters, which then give up
+        apq.close();
+        ASSERT_EQ(apq.isClosed(), true);
+        ASSERT_EQ(apq.Waiting(), 0);
+        ASSERT_EQ(first.size(), 1);
+        ASSERT_EQ(second.size(), 0);
+        ASSERT_EQ(apq.enqueue(2, 2), false);
+        // a consumer arriving after close does not suspend
+        asyncConsumer(apq, third, 1);
+        ASSERT_EQ(apq.Waiting(), 0);
+        ASSERT_EQ(third.size(), 0);
+    }
+    // the destructor closes too; with an executor the waiters are woken
+    // after the queue is gone
+    deque<coroutine_handle<>> ready;
+    {
+        asyncpriorityqueue<int> apq([&](coroutine_handle<> h) { ready.push_back(h); });
+        asyncConsumer(apq, first, 1);
+        asyncConsumer(apq, second, 1);
+        ASSERT_EQ(apq.Waiting(), 2);
+    }
+    ASSERT_EQ(ready.size(), 2);
+    for (coroutine_handle<> h : ready) {
+        h.resume();
+    }
+    ASSERT_EQ(first.size(), 1);
+    ASSERT_EQ(second.size(), 0);
+}
+
+// coroutine type that stays suspended until its owner destroys it
+struct ownedtask {
+    struct promise_type {
+        ownedtask get_return_object() { return {coroutine_handle<promise_type>::from_promise(*this)}; }
+        suspend_never initial_suspend() { return {}; }
+        suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { terminate(); }
+    };
+    coroutine_handle<promise_type> handle;
+};
+
+static ownedtask ownedConsumer(asyncpriorityqueue<int>& apq, deque<int>& out) {
+    optional<int> value = co_await apq.async_dequeue();
+    if (value) {
+        out.push_back(*value);
+    }
+}
+
+TEST(asyncpriorityqueue, destroySuspended) {
+    asyncpriorityqueue<int> apq;
+    deque<int> first, second, third;
+    ownedtask a = ownedConsumer(apq, first);
+    ownedtask b = ownedConsumer(apq, second);
+    ownedtask c = ownedConsumer(apq, third);
+    ASSERT_EQ(apq.Waiting(), 3);
+    // destroying suspended consumers takes them off the waiter list
+    b.handle.destroy();
+    a.handle.destroy();
+    ASSERT_EQ(apq.Waiting(), 1);
+    apq.enqueue(5, 5);
+    ASSERT_EQ(third.size(), 1);
+    ASSERT_EQ(third[0], 5);
+    ASSERT_EQ(first.size(), 0);
+    ASSERT_EQ(second.size(), 0);
+    ASSERT_EQ(apq.Waiting(), 0);
+    c.handle.destroy();
+}
+
+TEST(priorityqueue, peekMax) {
+    priorityqueue<int> pqInt;
+    ASSERT_EQ(pqInt.peekMax(), 0);
+    pqInt.enqueue(1, 1000);
+    ASSERT_EQ(pqInt.peekMax(), 1);
+    pqInt.enqueue(2, 500);
+    pqInt.enqueue(3, 1500);
+    pqInt.enqueue(4, 1500);
+    pqInt.enqueue(5, 1250);
+    // first of the duplicates is the max
+    ASSERT_EQ(pqInt.peekMax(), 3);
+    ASSERT_EQ(pqInt.peek(), 2);
+    pqInt.enqueue(6, 1750);
+    ASSERT_EQ(pqInt.peekMax(), 6);
+    EXPECT_EQ(pqInt.Size(), 6);
+}
+
+TEST(priorityqueue, dequeueMax) {
+    priorityqueue<int> pqInt;
+    ASSERT_EQ(pqInt.dequeueMax(), 0);
+    pqInt.enqueue(1, 1000);
+    pqInt.enqueue(2, 500);
+    pqInt.enqueue(3, 1500);
+    pqInt.enqueue(4, 250);
+    pqInt.enqueue(5, 750);
+    pqInt.enqueue(6, 1250);
+    pqInt.enqueue(7, 1750);
+    pqInt.enqueue(8, 1000);
+    pqInt.enqueue(9, 1750);
+    pqInt.enqueue(10, 1400);
+    EXPECT_EQ(pqInt.Size(), 10);
+    ASSERT_EQ(pqInt.dequeueMax(), 7);
+    ASSERT_EQ(pqInt.dequeueMax(), 9);
+    ASSERT_EQ(pqInt.dequeueMax(), 3);
+    ASSERT_EQ(pqInt.peekMax(), 10);
+    ASSERT_EQ(pqInt.dequeueMax(), 10);
+    ASSERT_EQ(pqInt.dequeueMax(), 6);
+    ASSERT_EQ(pqInt.Size(), 5);
+    ASSERT_EQ(pqInt.toString(), "250 value: 4\n500 value: 2\n750 value: 5\n1000 value: 1\n1000 value: 8\n");
+    // mix both ends
+    ASSERT_EQ(pqInt.dequeue(), 4);
+    ASSERT_EQ(pqInt.dequeueMax(), 1);
+    ASSERT_EQ(pqInt.dequeue(), 2);
+    ASSERT_EQ(pqInt.dequeueMax(), 8);
+    ASSERT_EQ(pqInt.dequeueMax(), 5);
+    ASSERT_EQ(pqInt.Size(), 0);
+    ASSERT_EQ(pqInt.toString(), "");
+    ASSERT_EQ(pqInt.peekMax(), 0);
+    // root with duplicates only
+    pqInt.enqueue(1, 5);
+    pqInt.enqueue(2, 5);
+    pqInt.enqueue(3, 5);
+    ASSERT_EQ(pqInt.dequeue(), 1);
+    ASSERT_EQ(pqInt.peekMax(), 2);
+    ASSERT_EQ(pqInt.dequeueMax(), 2);
+    ASSERT_EQ(pqInt.dequeueMax(), 3);
+    ASSERT_EQ(pqInt.Size(), 0);
+}
+
+TEST(priorityqueue, minMaxRandomized) {
+    priorityqueue<int> pqInt;
+    multimap<int, int> expected;
+    srand(26);
+    for (int i = 0; i < 5000; i++) {
+        int op = rand() % 4;
+        if (op < 2 || expected.empty()) {
+            int priority = rand() % 50;
+            pqInt.enqueue(i, priority);
+            expected.insert({priority, i});
+        } else if (op == 2) {
+            ASSERT_EQ(pqInt.dequeue(), expected.begin()->second);
+            expected.erase(expected.begin());
+        } else {
+            // first inserted among the largest priority
+            auto it = expected.lower_bound(prev(expected.end())->first);
+            ASSERT_EQ(pqInt.peekMax(), it->second);
+            ASSERT_EQ(pqInt.dequeueMax(), it->second);
+            expected.erase(it);
+        }
+        ASSERT_EQ(pqInt.Size(), (int)expected.size());
+    }
+    stringstream ss;
+    for (auto& e : expected) {
+        ss << e.first << " value: " << e.second << endl;
+    }
+    ASSERT_EQ(pqInt.toString(), ss.str());
+}
+
+TEST(priorityqueue, build) {
+    vector<pair<int, int>> items;
+    priorityqueue<int> expected;
+    srand(29);
+    for (int i = 0; i < 2000; i++) {
+        int priority = rand() % 300;
+        items.push_back({i, priority});
+        expected.enqueue(i, priority);
+    }
+    for (int threads : {1, 2, 3, 4, 7, 16}) {
+        priorityqueue<int> pqInt(items.begin(), items.end(), threads);
+        ASSERT_EQ(pqInt.Size(), 2000);
+        // duplicates keep the order of the range
+        ASSERT_EQ(pqInt.toString(), expected.toString());
+        ASSERT_EQ(pqInt.peekMax(), expected.peekMax());
+        for (int i = 0; i < 1000; i++) {
+            ASSERT_EQ(pqInt.dequeue(), expected.dequeue());
+            ASSERT_EQ(pqInt.dequeueMax(), expected.dequeueMax());
+        }
+        ASSERT_EQ(pqInt.Size(), 0);
+        // refill the reference for the next thread count
+        for (auto& item : items) {
+            expected.enqueue(item.first, item.second);
+        }
+    }
+    // input iterators that cannot be split across threads
+    list<pair<int, int>> itemList(items.begin(), items.end());
+    priorityqueue<int> fromList(itemList.begin(), itemList.end(), 4);
+    ASSERT_EQ(fromList.toString(), expected.toString());
+    // an empty range gives an empty queue
+    priorityqueue<int> empty(items.end(), items.end());
+    ASSERT_EQ(empty.Size(), 0);
+    ASSERT_EQ(empty.toString(), "");
+}
+
+TEST(priorityqueue, parallelCopyAndClear) {
+    vector<pair<int, int>> items;
+    for (int i = 0; i < 1000; i++) {
+        items.push_back({i, (i * 37) % 211});
+    }
+    priorityqueue<int> pqInt(items.begin(), items.end(), 4);
+    priorityqueue<int> serial(items.begin(), items.end());
+    string expected = serial.toString();
+    ASSERT_EQ(pqInt.toString(), expected);
+    priorityqueue<int> copy;
+    copy.setThreads(8);
+    copy = pqInt;
+    ASSERT_EQ(copy.Size(), 1000);
+    ASSERT_EQ(copy == pqInt, true);
+    ASSERT_EQ(copy.toString(), expected);
+    ASSERT_EQ(copy.peekMax(), pqInt.peekMax());
+    // the copy is independent of the original
+    pqInt.clear();
+    ASSERT_EQ(pqInt.Size(), 0);
+    ASSERT_EQ(pqInt.toString(), "");
+    ASSERT_EQ(copy.toString(), expected);
+    copy.clear();
+    ASSERT_EQ(copy.Size(), 0);
+    // fewer nodes than threads
+    copy.enqueue(1, 5);
+    copy.enqueue(2, 5);
+    copy.enqueue(3, 7);
+    ASSERT_EQ(copy.toString(), "5 value: 1\n5 value: 2\n7 value: 3\n");
+}
+
+TEST(compactpriorityqueue, basics) {
+    compactpriorityqueue<int> pqInt;
+    compactpriorityqueue<string> pqString;
+    ASSERT_EQ(pqInt.Size(), 0);
+    ASSERT_EQ(pqInt.toString(), "");
+    ASSERT_EQ(pqInt.dequeue(), 0);
+    ASSERT_EQ(pqInt.peekMax(), 0);
+    pqInt.enqueue(5, 6);
+    pqInt.enqueue(3, 2);
+    pqInt.enqueue(17, 9);
+    pqInt.enqueue(10, 6);
+    pqInt.enqueue(2, 6);
+    pqInt.enqueue(1, 9);
+    pqInt.enqueue(4, 2);
+    EXPECT_EQ(pqInt.Size(), 7);
+    ASSERT_EQ(pqInt.toString(), "2 value: 3\n2 value: 4\n6 value: 5\n6 value: 10\n6 value: 2\n9 value: 17\n9 value: 1\n");
+    ASSERT_EQ(pqInt.peek(), 3);
+    ASSERT_EQ(pqInt.peekMax(), 17);
+    ASSERT_EQ(pqInt.dequeue(), 3);
+    ASSERT_EQ(pqInt.dequeueMax(), 17);
+    ASSERT_EQ(pqInt.dequeue(), 4);
+    ASSERT_EQ(pqInt.dequeue(), 5);
+    ASSERT_EQ(pqInt.Size(), 3);
+    pqString.enqueue("ABC", 2);
+    pqString.enqueue("XYZ", 1);
+    ASSERT_EQ(pqString.toString(), "1 value: XYZ\n2 value: ABC\n");
+    pqInt.clear();
+    ASSERT_EQ(pqInt.Size(), 0);
+    ASSERT_EQ(pqInt.toString(), "");
+}
+
+TEST(compactpriorityqueue, beginAndNext) {
+    int value;
+    int priority;
+    compactpriorityqueue<int> pqInt;
+    pqInt.enqueue(1, 6);
+    pqInt.enqueue(2, 4);
+    pqInt.enqueue(3, 8);
+    pqInt.enqueue(4, 5);
+    pqInt.enqueue(5, 5);
+    pqInt.enqueue(6, 1);
+    pqInt.begin();
+    ASSERT_EQ(pqInt.next(value, priority), true);
+    ASSERT_EQ(priority, 1);
+    ASSERT_EQ(pqInt.next(value, priority), true);
+    ASSERT_EQ(priority, 4);
+    ASSERT_EQ(pqInt.next(value, priority), true);
+    ASSERT_EQ(value, 4);
+    ASSERT_EQ(pqInt.next(value, priority), true);
+    ASSERT_EQ(value, 5);
+    ASSERT_EQ(pqInt.next(value, priority), true);
+    ASSERT_EQ(priority, 6);
+    // like priorityqueue, the last element comes back with false
+    ASSERT_EQ(pqInt.next(value, priority), false);
+    ASSERT_EQ(priority, 8);
+    ASSERT_EQ(pqInt.next(value, priority), false);
+    ASSERT_EQ(priority, -999);
+}
+
+TEST(compactpriorityqueue, matchesPriorityqueue) {
+    priorityqueue<int> expected;
+    compactpriorityqueue<int> pqInt;
+    srand(30);
+    for (int i = 0; i < 5000; i++) {
+        int op = rand() % 4;
+        if (op < 2) {
+            int priority = rand() % 100;
+            expected.enqueue(i, priority);
+            pqInt.enqueue(i, priority);
+        } else if (op == 2) {
+            ASSERT_EQ(pqInt.dequeue(), expected.dequeue());
+        } else {
+            ASSERT_EQ(pqInt.peekMax(), expected.peekMax());
+            ASSERT_EQ(pqInt.dequeueMax(), expected.dequeueMax());
+        }
+        ASSERT_EQ(pqInt.Size(), expected.Size());
+    }
+    ASSERT_EQ(pqInt.toString(), expected.toString());
+    // copies are independent and compare equal
+    compactpriorityqueue<int> copy;
+    copy = pqInt;
+    ASSERT_EQ(copy == pqInt, true);
+    copy.dequeueMax();
+    ASSERT_EQ(copy == pqInt, false);
+    ASSERT_EQ(pqInt.toString(), expected.toString());
+}
+
+TEST(persistentpriorityqueue, basics) {
+    persistentpriorityqueue<int> pqInt;
+    ASSERT_EQ(pqInt.Size(), 0);
+    ASSERT_EQ(pqInt.toString(), "");
+    ASSERT_EQ(pqInt.dequeue(), 0);
+    pqInt.enqueue(5, 6);
+    pqInt.enqueue(3, 2);
+    pqInt.enqueue(17, 9);
+    pqInt.enqueue(10, 6);
+    pqInt.enqueue(2, 6);
+    pqInt.enqueue(4, 2);
+    EXPECT_EQ(pqInt.Size(), 6);
+    ASSERT_EQ(pqInt.toString(), "2 value: 3\n2 value: 4\n6 value: 5\n6 value: 10\n6 value: 2\n9 value: 17\n");
+    ASSERT_EQ(pqInt.peek(), 3);
+    ASSERT_EQ(pqInt.dequeue(), 3);
+    ASSERT_EQ(pqInt.dequeue(), 4);
+    ASSERT_EQ(pqInt.dequeue(), 5);
+    ASSERT_EQ(pqInt.dequeue(), 10);
+    ASSERT_EQ(pqInt.Size(), 2);
+    pqInt.clear();
+    ASSERT_EQ(pqInt.Size(), 0);
+}
+
+TEST(persistentpriorityqueue, snapshot) {
+    persistentpriorityqueue<int> pqInt;
+    pqInt.enqueue(1, 1000);
+    pqInt.enqueue(2, 500);
+    pqInt.enqueue(3, 1500);
+    pqInt.enqueue(4, 500);
+    persistentpriorityqueue<int>::view before = pqInt.snapshot();
+    string beforeString = "500 value: 2\n500 value: 4\n1000 value: 1\n1500 value: 3\n";
+    ASSERT_EQ(before.Size(), 4);
+    ASSERT_EQ(before.toString(), beforeString);
+    // later writes do not show up in the snapshot
+    pqInt.enqueue(5, 250);
+    pqInt.enqueue(6, 500);
+    ASSERT_EQ(pqInt.dequeue(), 5);
+    ASSERT_EQ(pqInt.dequeue(), 2);
+    ASSERT_EQ(before.Size(), 4);
+    ASSERT_EQ(before.toString(), beforeString);
+    ASSERT_EQ(pqInt.Size(), 4);
+    // iteration over the snapshot
+    int value;
+    int priority;
+    before.begin();
+    ASSERT_EQ(before.next(value, priority), true);
+    ASSERT_EQ(value, 2);
+    ASSERT_EQ(before.next(value, priority), true);
+    ASSERT_EQ(value, 4);
+    ASSERT_EQ(before.next(value, priority), true);
+    ASSERT_EQ(value, 1);
+    ASSERT_EQ(before.next(value, priority), false);
+    ASSERT_EQ(value, 3);
+    // equality
+    persistentpriorityqueue<int>::view after = pqInt.snapshot();
+    ASSERT_EQ(after == pqInt.snapshot(), true);
+    ASSERT_EQ(after == before, false);
+    persistentpriorityqueue<int> other;
+    other.enqueue(1, 1000);
+    other.enqueue(2, 500);
+    other.enqueue(3, 1500);
+    other.enqueue(4, 500);
+    ASSERT_EQ(other.snapshot() == before, true);
+    // snapshots outlive the queue
+    persistentpriorityqueue<int>* temp = new persistentpriorityqueue<int>();
+    temp->enqueue(7, 7);
+    persistentpriorityqueue<int>::view orphan = temp->snapshot();
+    delete temp;
+    ASSERT_EQ(orphan.toString(), "7 value: 7\n");
+}
+
+TEST(persistentpriorityqueue, concurrentSnapshots) {
+    persistentpriorityqueue<int> pqInt;
+    atomic<bool> done(false);
+    bool consistent = true;
+    // a monitor takes snapshots while the writer keeps going
+    thread monitor([&] {
+        while (!done) {
+            persistentpriorityqueue<int>::view v = pqInt.snapshot();
+            string s = v.toString();
+            if ((int)count(s.begin(), s.end(), '\n') != v.Size()) {
+                consistent = false;
+            }
+        }
+    });
+    for (int i = 0; i < 20000; i++) {
+        pqInt.enqueue(i, (i * 7919) % 500);
+        if (i % 3 == 0) {
+            pqInt.dequeue();
+        }
+    }
+    done = true;
+    monitor.join();
+    ASSERT_EQ(consistent, true);
+    ASSERT_EQ(pqInt.Size(), 20000 - 6667);
+}
+
+TEST(persistentpriorityqueue, duplicates) {
+    persistentpriorityqueue<int> pqInt;
+    for (int i = 0; i < 20000; i++) {
+        pqInt.enqueue(i, (i % 2 == 0) ? 7 : 3);
+    }
+    persistentpriorityqueue<int>::view before = pqInt.snapshot();
+    ASSERT_EQ(before.Size(), 20000);
+    // equal priorities come out in enqueue order
+    for (int i = 1; i < 20000; i += 2) {
+        ASSERT_EQ(pqInt.dequeue(), i);
+    }
+    for (int i = 0; i < 20000; i += 2) {
+        ASSERT_EQ(pqInt.dequeue(), i);
+    }
+    ASSERT_EQ(pqInt.Size(), 0);
+    // the snapshot still sees every element, in the same order
+    int value = 0;
+    int priority = 0;
+    int seen = 0;
+    before.begin();
+    while (before.next(value, priority)) {
+        ASSERT_EQ(value, (seen < 10000) ? seen * 2 + 1 : (seen - 10000) * 2);
+        seen++;
+    }
+    ASSERT_EQ(value, 19998);
+    ASSERT_EQ(seen, 19999);
+}
+
+TEST(priorityqueue, countRange) {
+    priorityqueue<int> pqInt;
+    ASSERT_EQ(pqInt.countRange(0, 100), 0);
+    pqInt.enqueue(1, 1000);
+    pqInt.enqueue(2, 500);
+    pqInt.enqueue(3, 1500);
+    pqInt.enqueue(4, 250);
+    pqInt.enqueue(5, 750);
+    pqInt.enqueue(6, 1250);
+    pqInt.enqueue(7, 1750);
+    pqInt.enqueue(8, 1000);
+    pqInt.enqueue(9, 500);
+    ASSERT_EQ(pqInt.countRange(INT_MIN, INT_MAX), 9);
+    ASSERT_EQ(pqInt.countRange(500, 1000), 5);
+    ASSERT_EQ(pqInt.countRange(501, 999), 1);
+    ASSERT_EQ(pqInt.countRange(1000, 1000), 2);
+    ASSERT_EQ(pqInt.countRange(1751, 2000), 0);
+    ASSERT_EQ(pqInt.countRange(1000, 500), 0);
+    // counts follow dequeues from both ends
+    pqInt.dequeue();
+    pqInt.dequeueMax();
+    pqInt.dequeue();
+    ASSERT_EQ(pqInt.countRange(INT_MIN, INT_MAX), 6);
+    ASSERT_EQ(pqInt.countRange(500, 1000), 4);
+}
+
+TEST(priorityqueue, extractAndEraseRange) {
+    priorityqueue<int> pqInt;
+    pqInt.enqueue(1, 1000);
+    pqInt.enqueue(2, 500);
+    pqInt.enqueue(3, 1500);
+    pqInt.enqueue(4, 250);
+    pqInt.enqueue(5, 750);
+    pqInt.enqueue(6, 1250);
+    pqInt.enqueue(7, 1750);
+    pqInt.enqueue(8, 1000);
+    pqInt.enqueue(9, 500);
+    vector<pair<int, int>> out;
+    ASSERT_EQ(pqInt.extractRange(500, 1000, out), 5);
+    ASSERT_EQ(out.size(), 5);
+    ASSERT_EQ(out[0], make_pair(2, 500));
+    ASSERT_EQ(out[1], make_pair(9, 500));
+    ASSERT_EQ(out[2], make_pair(5, 750));
+    ASSERT_EQ(out[3], make_pair(1, 1000));
+    ASSERT_EQ(out[4], make_pair(8, 1000));
+    ASSERT_EQ(pqInt.Size(), 4);
+    ASSERT_EQ(pqInt.toString(), "250 value: 4\n1250 value: 6\n1500 value: 3\n1750 value: 7\n");
+    ASSERT_EQ(pqInt.eraseRange(1300, INT_MAX), 2);
+    ASSERT_EQ(pqInt.Size(), 2);
+    ASSERT_EQ(pqInt.peekMax(), 6);
+    ASSERT_EQ(pqInt.eraseRange(0, 100), 0);
+    ASSERT_EQ(pqInt.eraseRange(INT_MIN, INT_MAX), 2);
+    ASSERT_EQ(pqInt.Size(), 0);
+    ASSERT_EQ(pqInt.toString(), "");
+    ASSERT_EQ(pqInt.dequeue(), 0);
+}
+
+TEST(priorityqueue, split) {
+    priorityqueue<int> pqInt;
+    priorityqueue<int> upper;
+    upper.enqueue(99, 99);
+    pqInt.enqueue(1, 1000);
+    pqInt.enqueue(2, 500);
+    pqInt.enqueue(3, 1500);
+    pqInt.enqueue(4, 250);
+    pqInt.enqueue(5, 1250);
+    pqInt.enqueue(6, 1000);
+    pqInt.split(1000, upper);
+    ASSERT_EQ(pqInt.Size(), 2);
+    ASSERT_EQ(upper.Size(), 4);
+    ASSERT_EQ(pqInt.toString(), "250 value: 4\n500 value: 2\n");
+    ASSERT_EQ(upper.toString(), "1000 value: 1\n1000 value: 6\n1250 value: 5\n1500 value: 3\n");
+    ASSERT_EQ(pqInt.peekMax(), 2);
+    ASSERT_EQ(upper.peek(), 1);
+    // parent links are intact for traversal
+    int value;
+    int priority;
+    upper.begin();
+    upper.next(value, priority);
+    ASSERT_EQ(value, 1);
+    upper.next(value, priority);
+    ASSERT_EQ(value, 6);
+    upper.next(value, priority);
+    ASSERT_EQ(value, 5);
+    upper.next(value, priority);
+    ASSERT_EQ(value, 3);
+    ASSERT_EQ(upper.dequeue(), 1);
+    ASSERT_EQ(upper.dequeue(), 6);
+    ASSERT_EQ(upper.dequeueMax(), 3);
+}
+
+TEST(priorityqueue, rangeRandomized) {
+    priorityqueue<int> pqInt;
+    multimap<int, int> expected;
+    srand(32);
+    for (int i = 0; i < 3000; i++) {
+        int op = rand() % 10;
+        int lo = rand() % 200;
+        int hi = lo + rand() % 40;
+        if (op < 6) {
+            int priority = rand() % 200;
+            pqInt.enqueue(i, priority);
+            expected.insert({priority, i});
+        } else if (op == 6) {
+            ASSERT_EQ(pqInt.dequeue(), expected.empty() ? 0 : expected.begin()->second);
+            if (!expected.empty()) expected.erase(expected.begin());
+        } else if (op == 7) {
+            vector<pair<int, int>> out;
+            auto first = expected.lower_bound(lo);
+            auto last = expected.upper_bound(hi);
+            vector<pair<int, int>> want;
+            for (auto it = first; it != last; ++it) {
+                want.push_back({it->second, it->first});
+            }
+            ASSERT_EQ(pqInt.extractRange(lo, hi, out), (int)want.size());
+            ASSERT_EQ(out, want);
+            expected.erase(first, last);
+        } else if (op == 8) {
+            ASSERT_EQ(pqInt.eraseRange(lo, hi), (int)distance(expected.lower_bound(lo), expected.upper_bound(hi)));
+            expected.erase(expected.lower_bound(lo), expected.upper_bound(hi));
+        } else {
+            // split, then enqueue the upper part back
+            priorityqueue<int> upper;
+            vector<pair<int, int>> out;
+            pqInt.split(lo, upper);
+            ASSERT_EQ(pqInt.Size(), (int)distance(expected.begin(), expected.lower_bound(lo)));
+            ASSERT_EQ(upper.Size(), (int)distance(expected.lower_bound(lo), expected.end()));
+            upper.extractRange(INT_MIN, INT_MAX, out);
+            for (auto& item : out) {
+                pqInt.enqueue(item.first, item.second);
+            }
+        }
+        ASSERT_EQ(pqInt.Size(), (int)expected.size());
+        ASSERT_EQ(pqInt.countRange(lo, hi), (int)distance(expected.lower_bound(lo), expected.upper_bound(hi)));
+    }
+    stringstream ss;
+    for (auto& e : expected) {
+        ss << e.first << " value: " << e.second << endl;
+    }
+    ASSERT_EQ(pqInt.toString(), ss.str());
+    // parent links survive the cuts: walk with next(), drain from the top
+    int value = 0;
+    int priority = 0;
+    pqInt.begin();
+    for (auto& e : expected) {
+        pqInt.next(value, priority);
+        ASSERT_EQ(priority, e.first);
+    }
+    ASSERT_EQ(pqInt.next(value, priority), false);
+    while (!expected.empty()) {
+        auto top = expected.lower_bound(prev(expected.end())->first);
+        ASSERT_EQ(pqInt.dequeueMax(), top->second);
+        expected.erase(top);
+    }
+    ASSERT_EQ(pqInt.Size(), 0);
+}
+
+TEST(sharedpriorityqueue, basics) {
+    string name = "/pq-basics-" + to_string(getpid());
+    sharedpriorityqueue<int>::remove(name);
+    sharedpriorityqueue<int> spq;
+    ASSERT_EQ(spq.enqueue(1, 1), false);
+    ASSERT_EQ(spq.open(name, 4), true);
+    ASSERT_EQ(spq.Capacity(), 4);
+    ASSERT_EQ(spq.enqueue(5, 6), true);
+    ASSERT_EQ(spq.enqueue(3, 2), true);
+    ASSERT_EQ(spq.enqueue(10, 6), true);
+    ASSERT_EQ(spq.enqueue(4, 2), true);
+    // full
+    ASSERT_EQ(spq.enqueue(7, 1), false);
+    ASSERT_EQ(spq.Size(), 4);
+    ASSERT_EQ(spq.toString(), "2 value: 3\n2 value: 4\n6 value: 5\n6 value: 10\n");
+    // a second handle sees the same queue
+    sharedpriorityqueue<int> other;
+    ASSERT_EQ(other.open(name, 100), true);
+    ASSERT_EQ(other.Capacity(), 4);
+    ASSERT_EQ(other.peek(), 3);
+    ASSERT_EQ(other.dequeue(), 3);
+    ASSERT_EQ(spq.dequeue(), 4);
+    ASSERT_EQ(spq.enqueue(7, 1), true);
+    ASSERT_EQ(other.dequeue(), 7);
+    int value = 0;
+    ASSERT_EQ(spq.tryDequeueFor(value, chrono::milliseconds(1)), true);
+    ASSERT_EQ(value, 5);
+    spq.clear();
+    ASSERT_EQ(other.Size(), 0);
+    ASSERT_EQ(other.tryDequeue(value), false);
+    ASSERT_EQ(other.tryDequeueFor(value, chrono::milliseconds(10)), false);
+    sharedpriorityqueue<int>::remove(name);
+}
+
+static_assert(!is_copy_constructible_v<sharedpriorityqueue<int>> && !is_copy_assignable_v<sharedpriorityqueue<int>>,
+              "sharedpriorityqueue handles must not be copied");
+
+TEST(sharedpriorityqueue, twoProcesses) {
+    string name = "/pq-two-" + to_string(getpid());
+    sharedpriorityqueue<int>::remove(name);
+    sharedpriorityqueue<int> consumer;
+    ASSERT_EQ(consumer.open(name, 1000), true);
+    pid_t child = fork();
+    if (child == 0) {
+        // producer process
+        sharedpriorityqueue<int> producer;
+        if (!producer.open(name, 0)) _exit(1);
+        for (int i = 0; i < 500; i++) {
+            producer.enqueue(i, 0);
+        }
+        _exit(0);
+    }
+    // duplicates come out in the order the other process enqueued them
+    for (int i = 0; i < 500; i++) {
+        int value = -1;
+        ASSERT_EQ(consumer.waitDequeue(value), true);
+        ASSERT_EQ(value, i);
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    ASSERT_EQ(WEXITSTATUS(status), 0);
+    ASSERT_EQ(consumer.Size(), 0);
+    sharedpriorityqueue<int>::remove(name);
+}
+
+TEST(sharedpriorityqueue, creatorDiesDuringSetup) {
+    string name = "/pq-setup-" + to_string(getpid());
+    // step 0 dies right after creating the segment, step 1 after sizing it
+    for (int step = 0; step < 2; step++) {
+        sharedpriorityqueue<int>::remove(name);
+        pid_t child = fork();
+        if (child == 0) {
+            int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+            if (fd < 0 || flock(fd, LOCK_EX) != 0) _exit(1);
+            if (step == 1 && ftruncate(fd, 4096) != 0) _exit(1);
+            _exit(0);
+        }
+        int status = 0;
+        waitpid(child, &status, 0);
+        ASSERT_EQ(WEXITSTATUS(status), 0);
+        auto start = chrono::steady_clock::now();
+        sharedpriorityqueue<int> spq;
+        ASSERT_EQ(spq.open(name, 8), true);
+        ASSERT_LT(chrono::steady_clock::now() - start, chrono::milliseconds(500));
+        ASSERT_EQ(spq.Capacity(), 8);
+        ASSERT_EQ(spq.enqueue(2, 2), true);
+        ASSERT_EQ(spq.enqueue(1, 1), true);
+        // later openers see the same, now set up, segment
+        sharedpriorityqueue<int> other;
+        ASSERT_EQ(other.open(name, 0), true);
+        ASSERT_EQ(other.dequeue(), 1);
+        ASSERT_EQ(spq.Size(), 1);
+    }
+    // a slow setup makes open() wait for as long as the process doing it
+    // is alive
+    sharedpriorityqueue<int>::remove(name);
+    int ready[2];
+    ASSERT_EQ(pipe(ready), 0);
+    pid_t child = fork();
+    if (child == 0) {
+        int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (fd < 0 || flock(fd, LOCK_EX) != 0) _exit(1);
+        write(ready[1], "x", 1);
+        pause();
+        _exit(0);
+    }
+    char c;
+    ASSERT_EQ(read(ready[0], &c, 1), 1);
+    sharedpriorityqueue<int> spq;
+    bool opened = false;
+    thread opener([&] {
+        opened = spq.open(name, 8);
+    });
+    this_thread::sleep_for(chrono::milliseconds(1500));
+    kill(child, SIGKILL);
+    waitpid(child, nullptr, 0);
+    opener.join();
+    ::close(ready[0]);
+    ::close(ready[1]);
+    ASSERT_EQ(opened, true);
+    ASSERT_EQ(spq.Capacity(), 8);
+    sharedpriorityqueue<int>::remove(name);
+}
+
+// forks a process that opens name, waits for a byte on go and then exits
+// holding the queue's lock
+static pid_t dieHoldingLock(const string& name, int go) {
+    pid_t child = fork();
+    if (child == 0) {
+        sharedpriorityqueue<int> worker;
+        char c;
+        if (!worker.open(name, 0) || read(go, &c, 1) != 1) _exit(1);
+        pthread_mutex_lock((pthread_mutex_t*)worker.getLock());
+        _exit(0);
+    }
+    return child;
+}
+
+TEST(sharedpriorityqueue, crashedProcess) {
+    string name = "/pq-crash-" + to_string(getpid());
+    sharedpriorityqueue<int>::remove(name);
+    sharedpriorityqueue<int> spq;
+    ASSERT_EQ(spq.open(name, 256), true);
+    multimap<int, int> expected;
+    for (int i = 0; i < 100; i++) {
+        spq.enqueue(i, i % 37);
+        expected.insert({i % 37, i});
+    }
+    int go[2];
+    ASSERT_EQ(pipe(go), 0);
+    pid_t child = dieHoldingLock(name, go[0]);
+    ASSERT_EQ(write(go[1], "x", 1), 1);
+    int status = 0;
+    waitpid(child, &status, 0);
+    ASSERT_EQ(WEXITSTATUS(status), 0);
+    // the next lock repairs the queue: everything is still there, in order
+    sharedpriorityqueue<int> other;
+    ASSERT_EQ(other.open(name, 0), true);
+    ASSERT_EQ(other.Size(), 100);
+    for (auto& e : expected) {
+        ASSERT_EQ(other.dequeue(), e.second);
+    }
+    // a consumer blocked on the empty queue while a process dies holding
+    // the lock still gets the next element
+    child = dieHoldingLock(name, go[0]);
+    int value = -1;
+    thread waiter([&] {
+        ASSERT_EQ(spq.waitDequeue(value), true);
+    });
+    this_thread::sleep_for(chrono::milliseconds(20));
+    ASSERT_EQ(write(go[1], "x", 1), 1);
+    waitpid(child, &status, 0);
+    ASSERT_EQ(WEXITSTATUS(status), 0);
+    other.enqueue(7, 7);
+    waiter.join();
+    ASSERT_EQ(value, 7);
+    ::close(go[0]);
+    ::close(go[1]);
+    // and still usable at full capacity
+    for (int i = 0; i < spq.Capacity(); i++) {
+        ASSERT_EQ(spq.enqueue(i, i), true);
+    }
+    ASSERT_EQ(spq.enqueue(0, 0), false);
+    sharedpriorityqueue<int>::remove(name);
+}
+
+TEST(sharedpriorityqueue, killedConsumers) {
+    string name = "/pq-killed-" + to_string(getpid());
+    sharedpriorityqueue<int>::remove(name);
+    sharedpriorityqueue<int> spq;
+    ASSERT_EQ(spq.open(name, 16), true);
+    // several consumers are killed while blocked on the empty queue
+    int ready[2];
+    ASSERT_EQ(pipe(ready), 0);
+    vector<pid_t> consumers;
+    for (int i = 0; i < 4; i++) {
+        pid_t child = fork();
+        if (child == 0) {
+            sharedpriorityqueue<int> consumer;
+            int value = 0;
+            if (!consumer.open(name, 0) || write(ready[1], "x", 1) != 1) _exit(1);
+            consumer.waitDequeue(value);
+            _exit(2);
+        }
+        consumers.push_back(child);
+    }
+    for (size_t i = 0; i < consumers.size(); i++) {
+        char c;
+        ASSERT_EQ(read(ready[0], &c, 1), 1);
+    }
+    this_thread::sleep_for(chrono::milliseconds(50));
+    for (pid_t child : consumers) {
+        kill(child, SIGKILL);
+        waitpid(child, nullptr, 0);
+    }
+    ::close(ready[0]);
+    ::close(ready[1]);
+    for (int i = 0; i < 10; i++) {
+        ASSERT_EQ(spq.enqueue(i, i), true);
+        ASSERT_EQ(spq.dequeue(), i);
+    }
+    // enqueue still returns, and a new consumer gets the element
+    pid_t child = fork();
+    if (child == 0) {
+        sharedpriorityqueue<int> consumer;
+        int value = 0;
+        if (!consumer.open(name, 0) || !consumer.waitDequeue(value)) _exit(1);
+        _exit(value);
+    }
+    this_thread::sleep_for(chrono::milliseconds(20));
+    ASSERT_EQ(spq.enqueue(5, 5), true);
+    int status = 0;
+    waitpid(child, &status, 0);
+    ASSERT_EQ(WEXITSTATUS(status), 5);
+    ASSERT_EQ(spq.Size(), 0);
+    sharedpriorityqueue<int>::remove(name);
+}
+
+// fills and drains a staticpriorityqueue at compile time
+constexpr int staticDrain() {
+    staticpriorityqueue<int, 4> pq;
+    pq.enqueue(3, 30);
+    pq.enqueue(1, 10);
+    pq.enqueue(4, 30);
+    pq.enqueue(2, 20);
+    int result = 0;
+    while (pq.Size() > 0) {
+        result = result * 10 + pq.dequeue();
+    }
+    return result;
+}
+static_assert(staticDrain() == 1234, "staticpriorityqueue must work at compile time");
+
+TEST(staticpriorityqueue, fullAndReuse) {
+    staticpriorityqueue<int, 4> pqInt;
+    ASSERT_EQ(pqInt.Capacity(), 4);
+    ASSERT_EQ(pqInt.tryEnqueue(5, 6), true);
+    ASSERT_EQ(pqInt.tryEnqueue(3, 2), true);
+    ASSERT_EQ(pqInt.tryEnqueue(17, 9), true);
+    ASSERT_EQ(pqInt.tryEnqueue(10, 6), true);
+    // full: tryEnqueue refuses, enqueue drops the value
+    ASSERT_EQ(pqInt.tryEnqueue(8, 1), false);
+    pqInt.enqueue(8, 1);
+    ASSERT_EQ(pqInt.Size(), 4);
+    ASSERT_EQ(pqInt.toString(), "2 value: 3\n6 value: 5\n6 value: 10\n9 value: 17\n");
+    // freed nodes are reused
+    ASSERT_EQ(pqInt.dequeue(), 3);
+    ASSERT_EQ(pqInt.dequeueMax(), 17);
+    ASSERT_EQ(pqInt.tryEnqueue(11, 7), true);
+    ASSERT_EQ(pqInt.tryEnqueue(12, 0), true);
+    ASSERT_EQ(pqInt.tryEnqueue(13, 0), false);
+    ASSERT_EQ(pqInt.toString(), "0 value: 12\n6 value: 5\n6 value: 10\n7 value: 11\n");
+    // and so is the whole array after clear
+    pqInt.clear();
+    ASSERT_EQ(pqInt.Size(), 0);
+    for (int i = 0; i < 4; i++) {
+        ASSERT_EQ(pqInt.tryEnqueue(i, i), true);
+    }
+    ASSERT_EQ(pqInt.tryEnqueue(4, 4), false);
+}
+
+TEST(staticpriorityqueue, beginAndNext) {
+    int value;
+    int priority;
+    staticpriorityqueue<int, 16> pqInt;
+    pqInt.enqueue(1, 6);
+    pqInt.enqueue(2, 4);
+    pqInt.enqueue(3, 8);
+    pqInt.enqueue(4, 5);
+    pqInt.enqueue(5, 5);
+    pqInt.enqueue(6, 1);
+    pqInt.begin();
+    ASSERT_EQ(pqInt.next(value, priority), true);
+    ASSERT_EQ(priority, 1);
+    ASSERT_EQ(pqInt.next(value, priority), true);
+    ASSERT_EQ(priority, 4);
+    ASSERT_EQ(pqInt.next(value, priority), true);
+    ASSERT_EQ(value, 4);
+    ASSERT_EQ(pqInt.next(value, priority), true);
+    ASSERT_EQ(value, 5);
+    ASSERT_EQ(pqInt.next(value, priority), true);
+    ASSERT_EQ(priority, 6);
+    ASSERT_EQ(pqInt.next(value, priority), false);
+    ASSERT_EQ(priority, 8);
+    ASSERT_EQ(pqInt.next(value, priority), false);
+    ASSERT_EQ(priority, -999);
+}